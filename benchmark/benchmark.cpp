@@ -0,0 +1,386 @@
+// Общий стенд для сравнения реализаций дерева на одинаковых нагрузках.
+// Запуск: benchmark [число ключей], по умолчанию 1000000
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "binarytree.h"
+#include "bplustree.h"
+#include "compacttree.h"
+#include "frozentree.h"
+#include "measure.h"
+#include "persistenttree.h"
+
+// Адаптер для BinaryTree<int> в режиме самобалансировки
+struct BinaryTreeEngine {
+    BinaryTree<int> tree;
+
+    BinaryTreeEngine() : tree(true) {}
+
+    static const char* name() {
+        return "BinaryTree (AVL)";
+    }
+
+    void insert(int key) {
+        tree.root = tree.insert(tree.root, key);
+    }
+
+    void erase(int key) {
+        tree.root = tree.deleteNode(tree.root, key);
+    }
+
+    bool search(int key) const {
+        return tree.search(tree.root, key) != nullptr;
+    }
+
+    long long findMin() {
+        return tree.findMin(tree.root)->key;
+    }
+
+    long long scan() const {
+        long long sum = 0;
+        tree.inOrderTraversal(tree.root, [&sum](const BinaryTree<int>::Node* node) { sum += node->key; });
+        return sum;
+    }
+
+    long long range(int from, int to) const {
+        long long sum = 0;
+        tree.rangeQuery(tree.root, from, to, [&sum](const BinaryTree<int>::Node* node) { sum += node->key; });
+        return sum;
+    }
+
+    // Тот же диапазон, но через полный симметричный обход с фильтрацией
+    long long rangeByScan(int from, int to) const {
+        long long sum = 0;
+        tree.inOrderTraversal(tree.root, [&](const BinaryTree<int>::Node* node) {
+            if (node->key >= from && node->key < to) {
+                sum += node->key;
+            }
+        });
+        return sum;
+    }
+};
+
+// Адаптер для BPlusTree
+struct BPlusTreeEngine {
+    BPlusTree tree;
+
+    static const char* name() {
+        return "BPlusTree";
+    }
+
+    void insert(int key) {
+        tree.insert(key);
+    }
+
+    void erase(int key) {
+        tree.deleteNode(key);
+    }
+
+    bool search(int key) const {
+        return tree.search(key);
+    }
+
+    long long findMin() {
+        return *tree.findMin();
+    }
+
+    long long scan() const {
+        long long sum = 0;
+        tree.inOrderTraversal([&sum](int key) { sum += key; });
+        return sum;
+    }
+
+    long long range(int from, int to) const {
+        long long sum = 0;
+        tree.rangeScan(from, to, [&sum](int key) { sum += key; });
+        return sum;
+    }
+
+    long long rangeByScan(int from, int to) const {
+        long long sum = 0;
+        tree.inOrderTraversal([&](int key) {
+            if (key >= from && key < to) {
+                sum += key;
+            }
+        });
+        return sum;
+    }
+};
+
+// Функция для прогона всех нагрузок на одном движке
+template <typename Engine>
+void runWorkloads(const std::vector<int>& sorted, const std::vector<int>& shuffled, const std::vector<int>& queries) {
+    const char* name = Engine::name();
+    {
+        Engine engine;
+        measure(name, "insert sorted", sorted.size(), [&] {
+            for (int key : sorted) {
+                engine.insert(key);
+            }
+            return 0LL;
+        });
+    }
+
+    Engine engine;
+    measure(name, "insert random", shuffled.size(), [&] {
+        for (int key : shuffled) {
+            engine.insert(key);
+        }
+        return 0LL;
+    });
+    measure(name, "search random", queries.size(), [&] {
+        long long found = 0;
+        for (int key : queries) {
+            found += engine.search(key);
+        }
+        return found;
+    });
+    measure(name, "findMin", queries.size(), [&] {
+        long long sum = 0;
+        for (std::size_t i = 0; i < queries.size(); i++) {
+            sum += engine.findMin();
+        }
+        return sum;
+    });
+    measure(name, "full in-order scan", shuffled.size(), [&] {
+        return engine.scan();
+    });
+    // Узкие диапазоны по 16 ключей (ключи чётные, ширина 32)
+    measure(name, "range 16 keys", queries.size(), [&] {
+        long long sum = 0;
+        for (int key : queries) {
+            sum += engine.range(key, key + 32);
+        }
+        return sum;
+    });
+    const std::size_t scans = 16;
+    measure(name, "range 16 by full scan", scans, [&] {
+        long long sum = 0;
+        for (std::size_t i = 0; i < scans; i++) {
+            sum += engine.rangeByScan(queries[i], queries[i] + 32);
+        }
+        return sum;
+    });
+    measure(name, "delete random", queries.size(), [&] {
+        for (int key : queries) {
+            engine.erase(key);
+        }
+        return 0LL;
+    });
+}
+
+// Функция для сравнения порядковых статистик BinaryTree по размерам поддеревьев
+// с выгрузкой ключей симметричным обходом и сортировкой выгруженного массива
+void runOrderStatistics(const std::vector<int>& shuffled, const std::vector<int>& queries) {
+    const char* name = "BinaryTree (AVL)";
+    BinaryTree<int> tree(true);
+    tree.root = tree.insertBatch(tree.root, shuffled.begin(), shuffled.end());
+
+    measure(name, "select k-th", queries.size(), [&] {
+        long long sum = 0;
+        for (int key : queries) {
+            sum += tree.select(tree.root, key % shuffled.size())->key;
+        }
+        return sum;
+    });
+    measure(name, "rank", queries.size(), [&] {
+        long long sum = 0;
+        for (int key : queries) {
+            sum += tree.rank(tree.root, key);
+        }
+        return sum;
+    });
+    const std::size_t dumps = 16;
+    measure(name, "k-th by dump and sort", dumps, [&] {
+        long long sum = 0;
+        for (std::size_t i = 0; i < dumps; i++) {
+            std::vector<int> keys;
+            tree.inOrderTraversal(tree.root, [&keys](const BinaryTree<int>::Node* node) { keys.push_back(node->key); });
+            std::sort(keys.begin(), keys.end());
+            sum += keys[queries[i] % keys.size()];
+        }
+        return sum;
+    });
+}
+
+// Функция для сравнения последовательного и параллельного полного обхода BinaryTree
+void runParallelScans(const std::vector<int>& sorted) {
+    const char* name = "BinaryTree (AVL)";
+    BinaryTree<int> tree(true);
+    tree.root = tree.bulkLoad(sorted.begin(), sorted.end());
+    typedef BinaryTree<int>::Node Node;
+
+    measure(name, "sum, in-order", sorted.size(), [&] {
+        long long sum = 0;
+        tree.inOrderTraversal(tree.root, [&sum](const Node* node) { sum += node->key; });
+        return sum;
+    });
+    measure(name, "sum, parallelReduce", sorted.size(), [&] {
+        return tree.parallelReduce(tree.root, 0LL, [](const Node* node) { return static_cast<long long>(node->key); },
+                                   [](long long a, long long b) { return a + b; });
+    });
+    std::vector<int> keys(sorted.size());
+    measure(name, "export, in-order", sorted.size(), [&] {
+        std::size_t i = 0;
+        tree.inOrderTraversal(tree.root, [&](const Node* node) { keys[i++] = node->key; });
+        return static_cast<long long>(keys.back());
+    });
+    measure(name, "export, parallel", sorted.size(), [&] {
+        tree.parallelInOrder(tree.root, keys.begin());
+        return static_cast<long long>(keys.back());
+    });
+}
+
+// Функция для замера текстовой выгрузки всех ключей в файл: поштучный вывод через поток и stdio
+// против BufferedWriter, который форматирует ключи через to_chars и пишет блоками
+void runTextExport(const std::vector<int>& sorted) {
+    typedef BinaryTree<int> Tree;
+    const char* path = "benchmark-export.txt";
+    Tree tree;
+    tree.root = tree.bulkLoad(sorted.begin(), sorted.end());
+    measure("BinaryTree", "text export, ofstream", sorted.size(), [&] {
+        std::ofstream out(path);
+        tree.inOrderTraversal(tree.root, [&](const Tree::Node* node) { out << node->key << " "; });
+        return static_cast<long long>(out.tellp());
+    });
+    measure("BinaryTree", "text export, fprintf", sorted.size(), [&] {
+        std::FILE* out = std::fopen(path, "w");
+        tree.inOrderTraversal(tree.root, [&](const Tree::Node* node) { std::fprintf(out, "%d ", node->key); });
+        long long size = std::ftell(out);
+        std::fclose(out);
+        return size;
+    });
+    measure("BinaryTree", "text export, writer", sorted.size(), [&] {
+        BufferedWriter out{ std::string(path) };
+        tree.writeKeys(tree.root, out);
+        return static_cast<long long>(out.flush());
+    });
+    std::remove(path);
+}
+
+// Функция для замера цены записи в PersistentTree: без снимков узлы меняются на месте,
+// со снимками каждая запись копирует разделённые узлы своего пути
+void runPersistent(const std::vector<int>& shuffled, const std::vector<int>& queries) {
+    const std::size_t periods[] = { 0, 1000, 1 };  // Снимок через столько записей, 0 — без снимков
+    const char* names[] = { "Persistent, no snap", "Persistent, snap/1000", "Persistent, snap/1" };
+    for (int i = 0; i < 3; i++) {
+        std::size_t period = periods[i];
+        PersistentTree<int> tree;
+        PersistentTree<int>::Snapshot latest;  // Держим только последний снимок, старые версии освобождаются
+        std::size_t writes = 0;
+        measure(names[i], "insert random", shuffled.size(), [&] {
+            for (int key : shuffled) {
+                tree.insert(key);
+                if (period != 0 && ++writes % period == 0) {
+                    latest = tree.snapshot();
+                }
+            }
+            return 0LL;
+        });
+        measure(names[i], "delete random", queries.size(), [&] {
+            for (int key : queries) {
+                tree.deleteNode(key);
+                if (period != 0 && ++writes % period == 0) {
+                    latest = tree.snapshot();
+                }
+            }
+            return 0LL;
+        });
+    }
+}
+
+// Функция для сравнения памяти и задержки поиска у дерева с указателями и у CompactTree с 12-байтными узлами.
+// Оба дерева строятся случайными вставками в режиме самобалансировки
+void runCompact(const std::vector<int>& shuffled, const std::vector<int>& queries) {
+    BinaryTree<int> pointerTree(true);
+    for (int key : shuffled) {
+        pointerTree.root = pointerTree.insert(pointerTree.root, key);
+    }
+    CompactTree compactTree(true);
+    for (int key : shuffled) {
+        compactTree.root = compactTree.insert(compactTree.root, key);
+    }
+    std::printf("%-26s %-22s %10.1f MB\n", "BinaryTree (AVL)", "node memory", pointerTree.memoryUsage() / 1e6);
+    std::printf("%-26s %-22s %10.1f MB\n", "CompactTree (AVL)", "node memory", compactTree.memoryUsage() / 1e6);
+
+    measure("BinaryTree (AVL)", "search random", queries.size(), [&] {
+        long long found = 0;
+        for (int key : queries) {
+            found += pointerTree.search(pointerTree.root, key) != nullptr;
+        }
+        return found;
+    });
+    measure("CompactTree (AVL)", "search random", queries.size(), [&] {
+        long long found = 0;
+        for (int key : queries) {
+            found += compactTree.search(compactTree.root, key) != CompactTree::Null;
+        }
+        return found;
+    });
+}
+
+// Функция для сравнения поиска в живом дереве и в его снимке FrozenTree (порядок Эйтцингера).
+// Для замеров из коммита запускать с 1000000, 10000000 и 100000000 ключей
+void runFrozen(const std::vector<int>& sorted, const std::vector<int>& queries) {
+    BinaryTree<int> tree(true);
+    tree.root = tree.bulkLoad(sorted.begin(), sorted.end());
+    FrozenTree<int> frozen = tree.freeze();
+
+    measure("BinaryTree (AVL)", "search random", queries.size(), [&] {
+        long long found = 0;
+        for (int key : queries) {
+            found += tree.search(tree.root, key) != nullptr;
+        }
+        return found;
+    });
+    measure("FrozenTree", "contains random", queries.size(), [&] {
+        long long found = 0;
+        for (int key : queries) {
+            found += frozen.contains(key);
+        }
+        return found;
+    });
+    measure("FrozenTree", "lowerBound random", queries.size(), [&] {
+        long long sum = 0;
+        for (int key : queries) {
+            const int* bound = frozen.lowerBound(key);
+            sum += bound != nullptr ? *bound : 0;
+        }
+        return sum;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    // Ключи — чётные числа, запросы наполовину попадают в дерево, наполовину нет
+    std::vector<int> sorted(count);
+    for (std::size_t i = 0; i < count; i++) {
+        sorted[i] = static_cast<int>(2 * i);
+    }
+    std::vector<int> shuffled(sorted);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+    std::vector<int> queries(count);
+    std::mt19937 random(2);
+    for (int& key : queries) {
+        key = static_cast<int>(random() % (2 * count));
+    }
+
+    std::printf("keys: %zu, pool threads: %zu\n", count, ThreadPool::instance().size());
+    runWorkloads<BinaryTreeEngine>(sorted, shuffled, queries);
+    runWorkloads<BPlusTreeEngine>(sorted, shuffled, queries);
+    runCompact(shuffled, queries);
+    runFrozen(sorted, queries);
+    runOrderStatistics(shuffled, queries);
+    runParallelScans(sorted);
+    runPersistent(shuffled, queries);
+    runTextExport(sorted);
+    return 0;
+}
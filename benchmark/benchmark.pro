@@ -0,0 +1,21 @@
+TEMPLATE = app
+CONFIG += console c++17
+CONFIG -= app_bundle qt
+
+# Поиск внутри узлов BPlusTree использует AVX2/SSE2, если они доступны при сборке
+!msvc: QMAKE_CXXFLAGS_RELEASE += -march=native
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    benchmark.cpp
+
+HEADERS += \
+    measure.h \
+    ../binarytree.h \
+    ../bufferedwriter.h \
+    ../bplustree.h \
+    ../compacttree.h \
+    ../frozentree.h \
+    ../persistenttree.h \
+    ../threadpool.h
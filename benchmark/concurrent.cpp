@@ -0,0 +1,224 @@
+// Многопоточный стенд: пропускная способность при 1–64 потоках для смесей чтения и записи.
+// Запуск: concurrent [число ключей] [длительность замера в мс], по умолчанию 1000000 и 200.
+// concurrent check [число ключей] [длительность в мс] — нагрузочная проверка освобождения узлов ConcurrentTree,
+// по умолчанию 100000 и 2000; код возврата 1, если найдены ошибки
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "binarytree.h"
+#include "concurrenttree.h"
+
+// BinaryTree под одним мьютексом — так дерево используется из нескольких потоков сейчас
+struct LockedTreeEngine {
+    BinaryTree<int> tree;
+    std::mutex mutex;
+
+    LockedTreeEngine() : tree(true) {}
+
+    static const char* name() {
+        return "BinaryTree + mutex";
+    }
+
+    bool contains(int key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tree.search(tree.root, key) != nullptr;
+    }
+
+    void insert(int key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.root = tree.insert(tree.root, key);
+    }
+
+    void erase(int key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.root = tree.deleteNode(tree.root, key);
+    }
+};
+
+struct ConcurrentTreeEngine {
+    ConcurrentTree<int> tree;
+
+    static const char* name() {
+        return "ConcurrentTree";
+    }
+
+    bool contains(int key) {
+        return tree.contains(key);
+    }
+
+    void insert(int key) {
+        tree.insert(key);
+    }
+
+    void erase(int key) {
+        tree.erase(key);
+    }
+};
+
+// Быстрый генератор для потоков: стандартные генераторы заметно дороже самой операции чтения
+struct XorShift {
+    std::uint64_t state;
+
+    explicit XorShift(std::uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    std::uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<std::uint32_t>(state >> 32);
+    }
+};
+
+// Функция для замера одной смеси: threads потоков в течение milliseconds выполняют операции,
+// из каждых 100 операций writePercent — запись (поровну вставки и удаления), остальные — поиск
+template <typename Engine>
+double measureMix(Engine& engine, int threads, int writePercent, std::uint32_t keyRange, int milliseconds) {
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::vector<std::uint64_t> counts(threads * 8);  // Счётчики через 64 байта, чтобы потоки не делили строку кэша
+    std::atomic<std::uint64_t> found(0);  // Результаты поиска используются, чтобы компилятор не выбросил его
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            XorShift random(t + 1);
+            std::uint64_t operations = 0;
+            std::uint64_t hits = 0;
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                std::uint32_t value = random.next();
+                int key = static_cast<int>(value % keyRange);
+                int roll = static_cast<int>((value >> 8) % 100);
+                if (roll >= writePercent) {
+                    hits += engine.contains(key);
+                }
+                else if (roll % 2 == 0) {
+                    engine.insert(key);
+                }
+                else {
+                    engine.erase(key);
+                }
+                operations++;
+            }
+            counts[t * 8] = operations;
+            found.fetch_add(hits, std::memory_order_relaxed);
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::uint64_t total = 0;
+    for (int t = 0; t < threads; t++) {
+        total += counts[t * 8];
+    }
+    return total / seconds / 1e6;
+}
+
+// Функция для прогона всех смесей и числа потоков на одном движке
+template <typename Engine>
+void runEngine(std::uint32_t count, int milliseconds) {
+    const int mixes[] = { 10, 50, 100 };  // Доля записи в процентах: 90/10, 50/50 и только запись
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+    for (int writePercent : mixes) {
+        Engine engine;
+        std::uint32_t keyRange = 2 * count;  // В дереве около половины ключей диапазона
+        for (std::uint32_t key = 0; key < keyRange; key += 2) {
+            engine.insert(static_cast<int>(key));
+        }
+        std::printf("%-20s reads/writes %3d/%-3d", Engine::name(), 100 - writePercent, writePercent);
+        for (int threads : threadCounts) {
+            std::printf(" %8.2f", measureMix(engine, threads, writePercent, keyRange, milliseconds));
+        }
+        std::printf("\n");
+    }
+}
+
+// Функция для нагрузочной проверки освобождения узлов. Чётные ключи лежат в дереве всё время, а нечётные
+// писатели вставляют и удаляют, и освобождённые узлы сразу идут под новые ключи. Читатель, дошедший до узла,
+// который освободили раньше времени, рано или поздно не найдёт чётный ключ. Ещё один поток держит Guard,
+// пока остальные сдвигают эпоху, и проверяет, что эпоха уходит не дальше чем на шаг. Возвращает число ошибок
+std::uint64_t checkReclamation(std::uint32_t count, int milliseconds) {
+    ConcurrentTree<int> tree(4);  // Мало шардов: писатели чаще освобождают узлы одного шарда
+    for (std::uint32_t key = 0; key < 2 * count; key += 2) {
+        tree.insert(static_cast<int>(key));
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<std::uint64_t> errors(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; t++) {
+        threads.emplace_back([&, t] {
+            XorShift random(t + 1);
+            while (!stop.load(std::memory_order_relaxed)) {
+                int key = static_cast<int>(random.next() % count) * 2 + 1;
+                if (!tree.insert(key)) {
+                    tree.erase(key);
+                }
+            }
+        });
+    }
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t] {
+            XorShift random(t + 100);
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (!tree.contains(static_cast<int>(random.next() % count) * 2)) {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    threads.emplace_back([&] {
+        EpochDomain& domain = EpochDomain::instance();
+        while (!stop.load(std::memory_order_relaxed)) {
+            EpochDomain::Guard guard;
+            std::uint64_t pinned = domain.current();  // Не меньше эпохи, объявленной guard
+            for (int i = 0; i < 1000; i++) {
+                domain.tryAdvance();
+                if (domain.current() > pinned + 1) {
+                    errors.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return errors.load();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "check") == 0) {
+        std::uint32_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+        int milliseconds = argc > 3 ? std::atoi(argv[3]) : 2000;
+        std::uint64_t errors = checkReclamation(count, milliseconds);
+        std::printf("reclamation check: %llu errors\n", static_cast<unsigned long long>(errors));
+        return errors != 0 ? 1 : 0;
+    }
+
+    std::uint32_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int milliseconds = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    std::printf("keys: %u, hardware threads: %u, Mops/s at 1 2 4 8 16 32 64 threads\n", count, std::thread::hardware_concurrency());
+    runEngine<LockedTreeEngine>(count, milliseconds);
+    runEngine<ConcurrentTreeEngine>(count, milliseconds);
+    return 0;
+}
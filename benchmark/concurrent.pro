@@ -0,0 +1,17 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle qt
+
+!msvc: QMAKE_CXXFLAGS_RELEASE += -march=native
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    concurrent.cpp
+
+HEADERS += \
+    ../binarytree.h \
+    ../bufferedwriter.h \
+    ../concurrenttree.h \
+    ../frozentree.h \
+    ../threadpool.h
@@ -0,0 +1,323 @@
+// Замеры "до и после" для изменений ядра BinaryTree: каждый раздел сравнивает прежний способ с нынешним
+// на той же нагрузке. Запуск: core [раздел] [число ключей], без аргументов — все разделы с размерами
+// по умолчанию. Разделы:
+//   autobalance — вставка и поиск упорядоченных ключей без балансировки и в режиме autoBalance (1000000)
+//   rebuild — балансировка цепочки: transformToAVL против перестройки rebuildBalanced (10000000)
+//   recursive — рекурсивные вставка, поиск и удаление против итеративных BinaryTree (1000000)
+//   pool-heap, pool-slab — заполнение, обновление и поиск с узлами из new/delete и из NodePool (10000000).
+//                          Пиковая память процесса накапливается, поэтому эти разделы запускаются по одному
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include "binarytree.h"
+#include "measure.h"
+
+typedef BinaryTree<int> Tree;
+
+// Функция для вставки ключей 0..count-1 по возрастанию и поиска каждого из них
+void insertAndSearchSorted(const char* variant, bool autoBalance, std::size_t count) {
+    Tree tree(autoBalance);
+    measure(variant, "insert sorted", count, [&] {
+        for (std::size_t i = 0; i < count; i++) {
+            tree.root = tree.insert(tree.root, static_cast<int>(i));
+        }
+        return 0LL;
+    });
+    measure(variant, "search sorted", count, [&] {
+        long long found = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            found += tree.search(tree.root, static_cast<int>(i)) != nullptr;
+        }
+        return found;
+    });
+    std::printf("%-26s %-22s %10d\n", variant, "height", tree.stats().height);
+}
+
+// Упорядоченные ключи без балансировки вытягивают дерево в цепочку, и вставка становится квадратичной,
+// поэтому этот вариант ограничен 20000 ключей
+void runAutoBalance(std::size_t count) {
+    insertAndSearchSorted("unbalanced, n<=20000", false, count < 20000 ? count : 20000);
+    insertAndSearchSorted("autoBalance", true, count);
+}
+
+// Функция для построения цепочки из count ключей: сбалансированное дерево выпрямляется в "лозу" за O(n),
+// а не строится квадратичной вставкой упорядоченных ключей. Высоты и размеры узлов лозы устаревшие —
+// обе сравниваемые балансировки пересчитывают их сами
+void buildChain(Tree& tree, std::size_t count) {
+    std::vector<int> keys(count);
+    for (std::size_t i = 0; i < count; i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    tree.root = tree.bulkLoad(keys.begin(), keys.end());
+    tree.treeToVine(&tree.root);
+}
+
+// transformToAVL делает не больше одного вращения на узел и оставляет цепочку высокой,
+// rebuildBalanced сворачивает её в идеально сбалансированное дерево
+void runRebuild(std::size_t count) {
+    {
+        Tree tree;
+        buildChain(tree, count);
+        measure("transformToAVL", "balance chain", count, [&] {
+            tree.root = tree.transformToAVL(tree.root);
+            return 0LL;
+        });
+        std::printf("%-26s %-22s %10d\n", "transformToAVL", "height", tree.stats().height);
+    }
+    Tree tree;
+    buildChain(tree, count);
+    measure("rebuildBalanced", "balance chain", count, [&] {
+        tree.root = tree.rebuildBalanced(tree.root);
+        return 0LL;
+    });
+    std::printf("%-26s %-22s %10d\n", "rebuildBalanced", "height", tree.stats().height);
+}
+
+// Узлы по одному из кучи, как до появления NodePool
+struct HeapNodes {
+    Tree::Node* create(int key) {
+        return new Tree::Node(key);
+    }
+
+    void destroy(Tree::Node* node) {
+        delete node;
+    }
+};
+
+// Прежняя рекурсивная реализация вставки, поиска и удаления для сравнения с итеративной. Узлы те же и
+// по умолчанию берутся из такого же пула, балансировка — та же функция rebalance, так что различается только обход.
+// Источник узлов Nodes заменяется на HeapNodes, чтобы сравнить пул с отдельными выделениями на одном коде
+template <typename Nodes = NodePool<Tree::Node, std::allocator<int>>>
+class RecursiveTree {
+public:
+    Tree::Node* root = nullptr;
+    bool autoBalance;
+
+    explicit RecursiveTree(bool autoBalance) : autoBalance(autoBalance) {}
+
+    ~RecursiveTree() {
+        destroySubtree(root);
+    }
+
+    Tree::Node* insert(Tree::Node* root, int key) {
+        if (root == nullptr) {
+            return nodes.create(key);
+        }
+        if (key < root->key) {
+            root->left = insert(root->left, key);
+        }
+        else if (key > root->key) {
+            root->right = insert(root->right, key);
+        }
+        else {
+            return root;
+        }
+        return autoBalance ? helper.rebalance(root) : root;
+    }
+
+    Tree::Node* deleteNode(Tree::Node* root, int value) {
+        if (root == nullptr) {
+            return root;
+        }
+        if (value < root->key) {
+            root->left = deleteNode(root->left, value);
+        }
+        else if (value > root->key) {
+            root->right = deleteNode(root->right, value);
+        }
+        else {
+            Tree::Node* child = root->left == nullptr ? root->right : root->right == nullptr ? root->left : nullptr;
+            if (root->left == nullptr || root->right == nullptr) {
+                nodes.destroy(root);
+                return child;
+            }
+            Tree::Node* temp = helper.findMin(root->right);
+            root->key = temp->key;
+            root->right = deleteNode(root->right, temp->key);  // Замена удаляемого узла минимальным узлом из правого поддерева
+        }
+        return autoBalance ? helper.rebalance(root) : root;
+    }
+
+    Tree::Node* search(Tree::Node* root, int value) const {
+        if (root == nullptr || root->key == value) {
+            return root;
+        }
+        return search(value < root->key ? root->left : root->right, value);
+    }
+
+private:
+    Nodes nodes;
+    Tree helper;  // Пустое дерево, у которого берутся rebalance и findMin
+
+    void destroySubtree(Tree::Node* node) {
+        if (node != nullptr) {
+            destroySubtree(node->left);
+            destroySubtree(node->right);
+            nodes.destroy(node);
+        }
+    }
+};
+
+// Функция для замера вставки и поиска ключей keys в порядке массива и их удаления в обратном порядке на дереве TreeType.
+// Обратный порядок нужен для цепочки: удаление в порядке вставки каждый раз снимало бы корень
+template <typename TreeType>
+void insertSearchDelete(const char* variant, const char* order, bool autoBalance, const std::vector<int>& keys) {
+    TreeType tree(autoBalance);
+    std::string insert = std::string("insert ") + order;
+    std::string search = std::string("search ") + order;
+    std::string erase = std::string("delete ") + order + " rev";
+    measure(variant, insert.c_str(), keys.size(), [&] {
+        for (int key : keys) {
+            tree.root = tree.insert(tree.root, key);
+        }
+        return 0LL;
+    });
+    measure(variant, search.c_str(), keys.size(), [&] {
+        long long found = 0;
+        for (int key : keys) {
+            found += tree.search(tree.root, key) != nullptr;
+        }
+        return found;
+    });
+    measure(variant, erase.c_str(), keys.size(), [&] {
+        for (auto key = keys.rbegin(); key != keys.rend(); ++key) {
+            tree.root = tree.deleteNode(tree.root, *key);
+        }
+        return static_cast<long long>(tree.root != nullptr);
+    });
+}
+
+// Случайные ключи в режиме autoBalance и упорядоченная цепочка без балансировки. Глубина рекурсии на цепочке
+// равна её длине, поэтому цепочка ограничена 10000 ключей: столько помещается в стек 1 МБ по умолчанию в Windows
+void runRecursive(std::size_t count) {
+    std::vector<int> keys(count);
+    for (std::size_t i = 0; i < count; i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+    insertSearchDelete<RecursiveTree<>>("recursive, AVL", "random", true, keys);
+    insertSearchDelete<Tree>("iterative, AVL", "random", true, keys);
+
+    keys.resize(count < 10000 ? count : 10000);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        keys[i] = static_cast<int>(i);
+    }
+    insertSearchDelete<RecursiveTree<>>("recursive, chain n<=10000", "sorted", false, keys);
+    insertSearchDelete<Tree>("iterative, chain n<=10000", "sorted", false, keys);
+}
+
+// Функция для получения пикового объёма памяти процесса в мегабайтах
+double peakMemoryMB() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize / 1048576.0;
+#else
+    std::FILE* file = std::fopen("/proc/self/status", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    char line[256];
+    long kilobytes = 0;
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            kilobytes = std::strtol(line + 6, nullptr, 10);
+            break;
+        }
+    }
+    std::fclose(file);
+    return kilobytes / 1024.0;
+#endif
+}
+
+// Функция для замера дерева с источником узлов Nodes: заполнение упорядоченными ключами в режиме AVL, затем count пар
+// удаление + вставка по случайным ключам и count случайных поисков. Обновление перемешивает узлы в памяти:
+// из кучи они приходят откуда придётся, пул отдаёт освободившееся место следующей вставке
+template <typename Nodes>
+void runPool(const char* variant, std::size_t count) {
+    RecursiveTree<Nodes> tree(true);
+    std::vector<int> keys(count);  // Ключи, которые сейчас в дереве
+    measure(variant, "fill sorted", count, [&] {
+        for (std::size_t i = 0; i < count; i++) {
+            keys[i] = static_cast<int>(i);
+            tree.root = tree.insert(tree.root, keys[i]);
+        }
+        return 0LL;
+    });
+    std::mt19937 random(42);
+    std::uniform_int_distribution<std::size_t> position(0, count - 1);
+    int next = static_cast<int>(count);  // Следующий ещё не вставленный ключ
+    measure(variant, "churn random", count, [&] {
+        for (std::size_t i = 0; i < count; i++) {
+            int& key = keys[position(random)];
+            tree.root = tree.deleteNode(tree.root, key);
+            key = next++;
+            tree.root = tree.insert(tree.root, key);
+        }
+        return 0LL;
+    });
+    measure(variant, "search random", count, [&] {
+        long long found = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            found += tree.search(tree.root, keys[position(random)]) != nullptr;
+        }
+        return found;
+    });
+    std::printf("%-26s %-22s %10.0f MB\n", variant, "peak memory", peakMemoryMB());
+}
+
+void runPoolHeap(std::size_t count) {
+    runPool<HeapNodes>("new/delete", count);
+}
+
+void runPoolSlab(std::size_t count) {
+    runPool<NodePool<Tree::Node, std::allocator<int>>>("NodePool", count);
+}
+
+// Раздел замеров: имя для командной строки, размер по умолчанию и функция
+struct Section {
+    const char* name;
+    std::size_t defaultCount;
+    void (*run)(std::size_t count);
+};
+
+const Section sections[] = {
+    { "autobalance", 1000000, runAutoBalance },
+    { "rebuild", 10000000, runRebuild },
+    { "recursive", 1000000, runRecursive },
+    { "pool-heap", 10000000, runPoolHeap },
+    { "pool-slab", 10000000, runPoolSlab },
+};
+
+int main(int argc, char* argv[]) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    std::size_t count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 0;
+    bool found = false;
+    for (const Section& section : sections) {
+        if (only != nullptr && std::strcmp(only, section.name) != 0) {
+            continue;
+        }
+        found = true;
+        std::size_t keys = count != 0 ? count : section.defaultCount;
+        std::printf("== %s, %zu keys\n", section.name, keys);
+        section.run(keys);
+    }
+    if (!found) {
+        std::fprintf(stderr, "unknown section: %s\n", only);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle qt
+
+INCLUDEPATH += ..
+
+win32: LIBS += -lpsapi
+
+SOURCES += \
+    core.cpp
+
+HEADERS += \
+    measure.h \
+    ../binarytree.h \
+    ../bufferedwriter.h \
+    ../frozentree.h \
+    ../threadpool.h
@@ -0,0 +1,95 @@
+// Стенд журнала: пропускная способность вставок с гарантией сохранности при разных окнах групповой фиксации.
+// Запуск: durable [каталог для файлов] [длительность замера в мс], по умолчанию . и 500
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "wal.h"
+
+// Функция для замера: threads потоков в течение milliseconds вставляют ключи, и каждая вставка
+// ждёт commit, то есть завершается, только оказавшись на диске. Возвращает тысячи вставок в секунду
+double measureDurable(const std::string& path, std::chrono::microseconds window, int threads, int milliseconds, double& perSync) {
+    std::remove((path + ".tree").c_str());
+    std::remove((path + ".wal").c_str());
+    DurableTree<int> tree(path, window);
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::atomic<std::uint64_t> total(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            std::uint64_t operations = 0;
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                tree.commit(tree.insert(static_cast<int>(operations * threads + t)));
+                operations++;
+            }
+            total.fetch_add(operations, std::memory_order_relaxed);
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+    stop.store(true, std::memory_order_relaxed);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::uint64_t syncs = tree.getLog().syncCount();
+    perSync = syncs != 0 ? static_cast<double>(total.load()) / syncs : 0;
+    return total.load() / seconds / 1e3;
+}
+
+// Функция для замера без ожидания каждой вставки: один поток вставляет count ключей и один раз вызывает commit
+// в конце, окно ограничивает лишь объём изменений, теряемых при сбое
+double measureBuffered(const std::string& path, std::chrono::microseconds window, int count) {
+    std::remove((path + ".tree").c_str());
+    std::remove((path + ".wal").c_str());
+    auto begin = std::chrono::steady_clock::now();
+    {
+        DurableTree<int> tree(path, window);
+        for (int key = 0; key < count; key++) {
+            tree.insert(key);
+        }
+        tree.commit();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    return count / seconds / 1e3;
+}
+
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : ".";
+    int milliseconds = argc > 2 ? std::atoi(argv[2]) : 500;
+    std::string path = directory + "/durable-bench";
+
+    const long long windows[] = { 0, 100, 1000, 10000 };  // Окно групповой фиксации в микросекундах
+    const int threadCounts[] = { 1, 8, 64 };
+
+    std::printf("durable inserts, kops/s (inserts per fsync) at 1 8 64 threads\n");
+    for (long long window : windows) {
+        std::printf("window %6lld us", window);
+        for (int threads : threadCounts) {
+            double perSync = 0;
+            double rate = measureDurable(path, std::chrono::microseconds(window), threads, milliseconds, perSync);
+            std::printf(" %10.1f (%7.1f)", rate, perSync);
+        }
+        std::printf("\n");
+    }
+
+    std::printf("buffered inserts, one commit at the end, kops/s\n");
+    for (long long window : windows) {
+        std::printf("window %6lld us %10.1f\n", window, measureBuffered(path, std::chrono::microseconds(window), 1000000));
+    }
+
+    std::remove((path + ".tree").c_str());
+    std::remove((path + ".wal").c_str());
+    return 0;
+}
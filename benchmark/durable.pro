@@ -0,0 +1,18 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle qt
+
+!msvc: QMAKE_CXXFLAGS_RELEASE += -march=native
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    durable.cpp
+
+HEADERS += \
+    ../binarytree.h \
+    ../bufferedwriter.h \
+    ../frozentree.h \
+    ../threadpool.h \
+    ../treeio.h \
+    ../wal.h
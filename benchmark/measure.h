@@ -0,0 +1,22 @@
+#ifndef BENCHMARK_MEASURE_H
+#define BENCHMARK_MEASURE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Результаты вычислений складываются сюда, чтобы компилятор не выбросил измеряемый код
+static volatile long long sink;
+
+// Функция для замера одной нагрузки: печатает миллионы операций в секунду и время одной операции.
+// body возвращает результат вычислений, он уходит в sink
+template <typename Body>
+void measure(const char* variant, const char* workload, std::size_t operations, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    sink = body();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-26s %-22s %10.3f Mops/s %12.0f ns/op %8.3f s\n", variant, workload, operations / seconds / 1e6,
+                seconds / operations * 1e9, seconds);
+}
+
+#endif // BENCHMARK_MEASURE_H
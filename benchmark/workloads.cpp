@@ -0,0 +1,361 @@
+// Стенд нагрузок BinaryTree: все основные операции на упорядоченных, обратных, равномерных, зипфовских
+// ключах и на скользящем окне. Для каждой операции печатаются пропускная способность, задержки p50/p99/p999,
+// высота дерева и занятая память; с --json те же результаты пишутся в файл для сравнения между коммитами.
+// Запуск: workloads [число ключей ...] [--json файл], по умолчанию 100000 и 1000000 ключей.
+// Задержка замеряется у каждой SampleEvery-й операции, поэтому часы почти не влияют на пропускную способность
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "binarytree.h"
+#include "measure.h"
+
+typedef BinaryTree<int> Tree;
+typedef Tree::Node Node;
+typedef std::chrono::steady_clock Clock;
+
+const std::size_t SampleEvery = 4;
+
+// Набор ключей одной нагрузки: порядок вставки и ключи для поиска из того же распределения
+struct Workload {
+    const char* name;
+    std::vector<int> keys;
+    std::vector<int> queries;
+    std::size_t window;  // Для скользящего окна — число живых ключей, иначе 0
+    bool monotone;  // Ключи идут по порядку: дерево без балансировки выродится в список
+};
+
+// Результат замера одной операции
+struct Result {
+    std::string workload;
+    std::size_t size;
+    std::string operation;
+    std::size_t operations;
+    double seconds;
+    double p50, p99, p999;  // Задержки в наносекундах, 0 — не замерялись
+    int height;
+    std::size_t memory;
+};
+
+// Генератор зипфовского распределения рангов 0..items-1 с параметром theta (метод Грея и др., как в YCSB)
+class ZipfGenerator {
+public:
+    ZipfGenerator(std::uint64_t items, double theta) : items(items), theta(theta) {
+        zetan = zeta(items);
+        double zeta2 = zeta(2);
+        alpha = 1.0 / (1.0 - theta);
+        eta = (1.0 - std::pow(2.0 / items, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+    }
+
+    template <typename Random>
+    std::uint64_t operator()(Random& random) {
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        double uz = u * zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, theta)) {
+            return 1;
+        }
+        std::uint64_t rank = static_cast<std::uint64_t>(items * std::pow(eta * u - eta + 1.0, alpha));
+        return rank < items ? rank : items - 1;
+    }
+
+private:
+    std::uint64_t items;
+    double theta;
+    double zetan;
+    double alpha;
+    double eta;
+
+    double zeta(std::uint64_t count) const {
+        double sum = 0;
+        for (std::uint64_t i = 1; i <= count; i++) {
+            sum += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        return sum;
+    }
+};
+
+// Функция для перемешивания ранга в ключ: частые ранги не должны оказаться соседними ключами
+int scramble(std::uint64_t rank, std::uint64_t range) {
+    std::uint64_t hash = (rank + 1) * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 29;
+    return static_cast<int>(hash % range);
+}
+
+// Функция для построения всех нагрузок размера count
+std::vector<Workload> makeWorkloads(std::size_t count) {
+    std::mt19937_64 random(42);
+    std::vector<Workload> workloads;
+    std::uint64_t range = 4 * static_cast<std::uint64_t>(count);  // Ключи из [0, 4n): половина поисков промахивается
+
+    Workload sorted = { "sorted", std::vector<int>(count), std::vector<int>(count), 0, true };
+    for (std::size_t i = 0; i < count; i++) {
+        sorted.keys[i] = static_cast<int>(i);
+    }
+    for (int& key : sorted.queries) {
+        key = static_cast<int>(random() % count);
+    }
+    workloads.push_back(sorted);
+
+    Workload reverse = sorted;
+    reverse.name = "reverse";
+    std::reverse(reverse.keys.begin(), reverse.keys.end());
+    workloads.push_back(reverse);
+
+    Workload uniform = { "uniform", std::vector<int>(count), std::vector<int>(count), 0, false };
+    for (int& key : uniform.keys) {
+        key = static_cast<int>(random() % range);
+    }
+    for (int& key : uniform.queries) {
+        key = static_cast<int>(random() % range);
+    }
+    workloads.push_back(uniform);
+
+    Workload zipfian = { "zipfian", std::vector<int>(count), std::vector<int>(count), 0, false };
+    ZipfGenerator zipf(count, 0.99);
+    for (int& key : zipfian.keys) {
+        key = scramble(zipf(random), range);
+    }
+    for (int& key : zipfian.queries) {
+        key = scramble(zipf(random), range);
+    }
+    workloads.push_back(zipfian);
+
+    // Скользящее окно: ключи растут, после вставки ключа i удаляется ключ i - window, поиск — внутри окна
+    std::size_t window = std::max<std::size_t>(count / 16, 1);
+    Workload sliding = { "sliding-window", sorted.keys, std::vector<int>(count), window, true };
+    for (int& key : sliding.queries) {
+        key = static_cast<int>(count - 1 - random() % window);
+    }
+    workloads.push_back(sliding);
+    return workloads;
+}
+
+// Функция для измерения высоты обходом: без балансировки высоты в узлах не поддерживаются
+int measureHeight(const Node* root) {
+    std::vector<std::pair<const Node*, int>> stack;
+    int height = 0;
+    if (root != nullptr) {
+        stack.push_back({ root, 1 });
+    }
+    while (!stack.empty()) {
+        std::pair<const Node*, int> top = stack.back();
+        stack.pop_back();
+        height = std::max(height, top.second);
+        if (top.first->left != nullptr) {
+            stack.push_back({ top.first->left, top.second + 1 });
+        }
+        if (top.first->right != nullptr) {
+            stack.push_back({ top.first->right, top.second + 1 });
+        }
+    }
+    return height;
+}
+
+// Накопитель одной операции: общее время и выборка задержек
+class Recorder {
+public:
+    template <typename Body>
+    void run(std::size_t index, Body body) {
+        if (index % SampleEvery == 0) {
+            Clock::time_point begin = Clock::now();
+            body();
+            samples.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count()));
+        }
+        else {
+            body();
+        }
+        operations++;
+    }
+
+    void start() {
+        begin = Clock::now();
+    }
+
+    void stop() {
+        seconds += std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+
+    Result result(const Workload& workload, const char* operation, const Tree& tree) {
+        Result result = { workload.name, workload.keys.size(), operation, operations, seconds,
+                          percentile(0.5), percentile(0.99), percentile(0.999), measureHeight(tree.root), tree.memoryUsage() };
+        return result;
+    }
+
+private:
+    std::vector<double> samples;
+    std::size_t operations = 0;
+    double seconds = 0;
+    Clock::time_point begin;
+
+    double percentile(double fraction) {
+        if (samples.empty()) {
+            return 0;
+        }
+        std::size_t index = std::min(samples.size() - 1, static_cast<std::size_t>(fraction * samples.size()));
+        std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+        return samples[index];
+    }
+};
+
+// Функция для замера всех операций на одной нагрузке
+void runWorkload(const Workload& workload, std::vector<Result>& results) {
+    Tree tree(true);
+    const std::vector<int>& keys = workload.keys;
+
+    Recorder inserts;
+    Recorder windowDeletes;
+    inserts.start();
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        inserts.run(i, [&] { tree.root = tree.insert(tree.root, keys[i]); });
+        if (workload.window != 0 && i >= workload.window) {
+            inserts.stop();
+            windowDeletes.start();
+            windowDeletes.run(i, [&] { tree.root = tree.deleteNode(tree.root, keys[i - workload.window]); });
+            windowDeletes.stop();
+            inserts.start();
+        }
+    }
+    inserts.stop();
+    results.push_back(inserts.result(workload, "insert", tree));
+    if (workload.window != 0) {
+        results.push_back(windowDeletes.result(workload, "deleteNode (window)", tree));
+    }
+
+    Recorder searches;
+    long long found = 0;
+    searches.start();
+    for (std::size_t i = 0; i < workload.queries.size(); i++) {
+        searches.run(i, [&] { found += tree.search(tree.root, workload.queries[i]) != nullptr; });
+    }
+    searches.stop();
+    sink = found;
+    results.push_back(searches.result(workload, "search", tree));
+
+    Recorder minimums;
+    long long sum = 0;
+    minimums.start();
+    for (std::size_t i = 0; i < workload.queries.size(); i++) {
+        minimums.run(i, [&] { sum += tree.findMin(tree.root)->key; });
+    }
+    minimums.stop();
+    sink = sum;
+    results.push_back(minimums.result(workload, "findMin", tree));
+
+    // Обходы: одна операция — посещение одного узла, задержка отдельного посещения не замеряется
+    const TraversalOrder orders[] = { TraversalOrder::PreOrder, TraversalOrder::InOrder, TraversalOrder::PostOrder };
+    const char* orderNames[] = { "preOrderTraversal", "inOrderTraversal", "postOrderTraversal" };
+    for (int i = 0; i < 3; i++) {
+        Recorder traversal;
+        std::size_t visited = 0;
+        traversal.start();
+        tree.traverse(tree.root, orders[i], [&](const Node* node) {
+            sum += node->key;
+            visited++;
+        });
+        traversal.stop();
+        sink = sum;
+        Result result = traversal.result(workload, orderNames[i], tree);
+        result.operations = visited;
+        results.push_back(result);
+    }
+
+    // transformToAVL на том же наборе, вставленном без балансировки. На упорядоченных ключах
+    // такое дерево — список, и сама вставка заняла бы O(n^2), поэтому там замер пропускается
+    if (!workload.monotone) {
+        Tree plain(false);
+        for (int key : keys) {
+            plain.root = plain.insert(plain.root, key);
+        }
+        Result before = Recorder().result(workload, "height before transformToAVL", plain);
+        results.push_back(before);
+        Recorder transform;
+        transform.start();
+        transform.run(0, [&] { plain.root = plain.transformToAVL(plain.root); });
+        transform.stop();
+        Result result = transform.result(workload, "transformToAVL", plain);
+        result.operations = plain.getSize(plain.root);
+        results.push_back(result);
+    }
+
+    Recorder deletes;
+    std::size_t first = workload.window != 0 ? keys.size() - std::min(keys.size(), workload.window) : 0;
+    deletes.start();
+    for (std::size_t i = first; i < keys.size(); i++) {
+        deletes.run(i, [&] { tree.root = tree.deleteNode(tree.root, keys[i]); });
+    }
+    deletes.stop();
+    results.push_back(deletes.result(workload, "deleteNode", tree));
+}
+
+void printResult(const Result& result) {
+    double mops = result.seconds > 0 ? result.operations / result.seconds / 1e6 : 0;
+    std::printf("%-15s %9zu %-30s %9.2f Mops/s %8.0f %8.0f %8.0f ns %6d %10.1f MiB\n", result.workload.c_str(), result.size,
+                result.operation.c_str(), mops, result.p50, result.p99, result.p999, result.height, result.memory / 1048576.0);
+}
+
+// Функция для записи результатов в JSON: массив объектов с одинаковыми полями
+void writeJson(const std::vector<Result>& results, const std::string& path) {
+    BufferedWriter out(path);
+    out << "{\n  \"benchmark\": \"workloads\",\n  \"sampleEvery\": " << SampleEvery << ",\n  \"results\": [\n";
+    char number[64];
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        double mops = result.seconds > 0 ? result.operations / result.seconds / 1e6 : 0;
+        out << "    {\"workload\": \"" << result.workload << "\", \"size\": " << result.size
+            << ", \"operation\": \"" << result.operation << "\", \"operations\": " << result.operations;
+        std::snprintf(number, sizeof(number), ", \"seconds\": %.6f, \"mops\": %.4f", result.seconds, mops);
+        out << number;
+        std::snprintf(number, sizeof(number), ", \"p50_ns\": %.0f, \"p99_ns\": %.0f", result.p50, result.p99);
+        out << number;
+        std::snprintf(number, sizeof(number), ", \"p999_ns\": %.0f", result.p999);
+        out << number << ", \"height\": " << result.height << ", \"memory_bytes\": " << result.memory << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    if (!out.flush()) {
+        std::fprintf(stderr, "%s: write failed\n", path.c_str());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::size_t> sizes;
+    std::string jsonPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        }
+        else {
+            sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) {
+        sizes = { 100000, 1000000 };
+    }
+
+    std::printf("%-15s %9s %-30s %16s %8s %8s %11s %6s %14s\n", "workload", "keys", "operation", "throughput", "p50", "p99",
+                "p999", "height", "memory");
+    std::vector<Result> results;
+    for (std::size_t count : sizes) {
+        for (const Workload& workload : makeWorkloads(count)) {
+            std::size_t first = results.size();
+            runWorkload(workload, results);
+            for (std::size_t i = first; i < results.size(); i++) {
+                printResult(results[i]);
+            }
+        }
+    }
+    if (!jsonPath.empty()) {
+        writeJson(results, jsonPath);
+    }
+    return 0;
+}
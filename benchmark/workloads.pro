@@ -0,0 +1,17 @@
+TEMPLATE = app
+CONFIG += console c++17 thread
+CONFIG -= app_bundle qt
+
+!msvc: QMAKE_CXXFLAGS_RELEASE += -march=native
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    workloads.cpp
+
+HEADERS += \
+    measure.h \
+    ../binarytree.h \
+    ../bufferedwriter.h \
+    ../frozentree.h \
+    ../threadpool.h
@@ -0,0 +1,1376 @@
+#ifndef BINARYTREE_H
+#define BINARYTREE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "bufferedwriter.h"
+#include "frozentree.h"
+#include "threadpool.h"
+
+// Хранилище значения узла. Для множеств (Value = void) не занимает места
+template <typename Value>
+struct NodeValue {
+    Value value;
+
+    template <typename... Args>
+    NodeValue(Args&&... args) : value(std::forward<Args>(args)...) {}
+};
+
+template <>
+struct NodeValue<void> {
+};
+
+// Узел дерева: ключ, значение (если есть), указатели на потомков и высота
+template <typename Key, typename Value>
+struct TreeNode : NodeValue<Value> {
+    Key key; // Ключ узла
+    TreeNode* left; // Указатель на левого потомка
+    TreeNode* right; // Указатель на правого потомка
+    int height; // Высота узла в дереве
+    std::uint32_t size; // Число узлов в поддереве с корнем в этом узле (занимает выравнивание после height)
+
+    // Конструктор узла: ключ и значение создаются на месте из переданных аргументов
+    template <typename K, typename... Args>
+    TreeNode(K&& key, Args&&... args)
+        : NodeValue<Value>(std::forward<Args>(args)...), key(std::forward<K>(key)), left(nullptr), right(nullptr), height(1), size(1) {}
+};
+
+// Пул узлов: узлы выделяются блоками (слэбами) по SlabSize штук, удалённые узлы
+// складываются в список свободных и переиспользуются, вся память возвращается разом.
+// Блоки выделяются через Allocator, перепривязанный к типу узла
+template <typename Node, typename Allocator>
+class NodePool {
+public:
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    typedef std::allocator_traits<NodeAllocator> Traits;
+
+    explicit NodePool(const Allocator& allocator = Allocator()) : allocator(allocator) {
+        freeList = nullptr;
+        used = SlabSize;  // Первый же запрос выделит новый блок
+    }
+
+    ~NodePool() {
+        release();
+    }
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    NodePool(NodePool&& other) noexcept
+        : allocator(std::move(other.allocator)), slabs(std::move(other.slabs)), freeList(other.freeList), used(other.used) {
+        other.slabs.clear();
+        other.freeList = nullptr;
+        other.used = SlabSize;
+    }
+
+    NodePool& operator=(NodePool&& other) noexcept {
+        if (this != &other) {
+            release();
+            allocator = std::move(other.allocator);
+            slabs = std::move(other.slabs);
+            freeList = other.freeList;
+            used = other.used;
+            other.slabs.clear();
+            other.freeList = nullptr;
+            other.used = SlabSize;
+        }
+        return *this;
+    }
+
+    // Функция для создания узла: берём место из списка свободных или следующее в текущем блоке
+    template <typename... Args>
+    Node* create(Args&&... args) {
+        Node* memory;
+        if (freeList != nullptr) {
+            memory = reinterpret_cast<Node*>(freeList);
+            freeList = freeList->next;
+        }
+        else {
+            if (used == SlabSize) {
+                slabs.push_back(Traits::allocate(allocator, SlabSize));  // Новый блок
+                used = 0;
+            }
+            memory = std::addressof(slabs.back()[used++]);
+        }
+        Traits::construct(allocator, memory, std::forward<Args>(args)...);
+        return memory;
+    }
+
+    // Функция для разрушения узла и возврата его места в пул
+    void destroy(Node* node) {
+        Traits::destroy(allocator, node);
+        freeList = ::new (static_cast<void*>(node)) FreeSlot{ freeList };
+    }
+
+    // Функция для освобождения всех блоков разом. Живые узлы к этому моменту должны быть
+    // разрушены владельцем, если их разрушение нетривиально
+    void release() {
+        for (Node* slab : slabs) {
+            Traits::deallocate(allocator, slab, SlabSize);
+        }
+        slabs.clear();
+        freeList = nullptr;
+        used = SlabSize;
+    }
+
+    // Объём памяти, выделенной под блоки, в байтах: живые узлы и свободные места
+    std::size_t allocatedBytes() const {
+        return slabs.size() * SlabSize * sizeof(Node);
+    }
+
+private:
+    static const int SlabSize = 4096;  // Число узлов в одном блоке
+
+    // Свободное место в блоке хранит ссылку на следующее свободное место
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    static_assert(sizeof(Node) >= sizeof(FreeSlot), "Node is too small for the free list");
+
+    NodeAllocator allocator;
+    std::vector<Node*> slabs;  // Выделенные блоки
+    FreeSlot* freeList;  // Голова списка свободных мест
+    int used;  // Число занятых мест в последнем блоке
+};
+
+// Функция для параллельной сортировки: части массива сортируются задачами пула потоков,
+// затем соседние упорядоченные части попарно сливаются, пары сливаются тоже параллельно
+template <typename Key, typename Compare>
+void parallelSort(std::vector<Key>& keys, const Compare& comp) {
+    const std::size_t MinChunk = 1 << 16;  // Меньшие части быстрее отсортировать в одном потоке
+    std::size_t threads = std::min<std::size_t>(ThreadPool::instance().size(), keys.size() / MinChunk);
+    if (threads <= 1) {
+        std::sort(keys.begin(), keys.end(), comp);
+        return;
+    }
+
+    std::vector<std::size_t> bounds(threads + 1);  // Границы частей: часть i занимает [bounds[i], bounds[i + 1])
+    for (std::size_t i = 0; i <= threads; i++) {
+        bounds[i] = keys.size() * i / threads;
+    }
+    auto begin = keys.begin();
+    ThreadPool::TaskGroup group;
+    for (std::size_t i = 0; i < threads; i++) {
+        group.run([&, i] { std::sort(begin + bounds[i], begin + bounds[i + 1], comp); });
+    }
+    group.wait();
+
+    for (std::size_t width = 1; width < threads; width *= 2) {
+        for (std::size_t i = 0; i + width < threads; i += 2 * width) {
+            std::size_t end = std::min(i + 2 * width, threads);
+            group.run([&, i, end] {
+                std::inplace_merge(begin + bounds[i], begin + bounds[i + width], begin + bounds[end], comp);
+            });
+        }
+        group.wait();
+    }
+}
+
+// Сбор статистики операций включается определением BINARYTREE_STATS до включения binarytree.h
+// (например, DEFINES += BINARYTREE_STATS в .pro). Без него счётчики вырезаются при компиляции
+#if defined(BINARYTREE_STATS)
+#define BINARYTREE_COUNT(statement) statement
+#else
+#define BINARYTREE_COUNT(statement) ((void)0)
+#endif
+
+// Снимок статистики дерева (см. BinaryTree::stats). Счётчики операций ненулевые только при BINARYTREE_STATS,
+// размер и высота вычисляются всегда
+struct TreeStats {
+    static const int PathBuckets = 48;  // Корзина i — поиски, прошедшие i узлов; последняя — все длиннее
+
+    std::uint64_t inserts = 0;
+    std::uint64_t duplicateInserts = 0;  // Вставки существующего ключа, дерево не менялось
+    std::uint64_t deletes = 0;
+    std::uint64_t missedDeletes = 0;  // Удаления отсутствующего ключа
+    std::uint64_t twoChildDeletes = 0;  // Удаления узла с двумя потомками через минимум правого поддерева
+    std::uint64_t searches = 0;
+    std::uint64_t searchHits = 0;
+    std::uint64_t pathLengths[PathBuckets] = {};
+    std::uint64_t leftRotations = 0;  // Все вращения: автобалансировка и transformToAVL
+    std::uint64_t rightRotations = 0;
+    std::uint64_t doubleRotations = 0;  // Из них пары вращений (лево-правые и право-левые)
+    std::uint64_t transformRotations = 0;  // Вращения, сделанные transformToAVL
+    std::uint64_t rebuilds = 0;  // Вызовы rebuildBalanced
+    std::size_t size = 0;
+    int height = 0;
+    int optimalHeight = 0;  // Наименьшая возможная высота для size узлов: ceil(log2(size + 1))
+
+    // Средняя длина пути поиска в узлах
+    double meanPathLength() const {
+        std::uint64_t total = 0;
+        for (int i = 0; i < PathBuckets; i++) {
+            total += pathLengths[i] * static_cast<std::uint64_t>(i);
+        }
+        return searches != 0 ? static_cast<double>(total) / searches : 0;
+    }
+
+    // Функция для вычисления длины пути, которую не превышает доля fraction поисков
+    int pathPercentile(double fraction) const {
+        std::uint64_t threshold = static_cast<std::uint64_t>(std::ceil(fraction * searches));
+        std::uint64_t seen = 0;
+        for (int i = 0; i < PathBuckets; i++) {
+            seen += pathLengths[i];
+            if (seen >= threshold && seen != 0) {
+                return i;
+            }
+        }
+        return 0;
+    }
+};
+
+// Событие журнала изменений формы дерева (см. BinaryTree::events)
+template <typename Key>
+struct TreeEvent {
+    enum Kind : std::uint8_t {
+        Insert,  // Вставлен ключ key
+        Delete,  // Удалён ключ key; узел с двумя потомками заменён минимальным узлом правого поддерева
+        RotateLeft,  // Левое вращение вокруг узла key: на его место встаёт правый потомок
+        RotateRight  // Правое вращение вокруг узла key: на его место встаёт левый потомок
+    };
+
+    Kind kind;
+    Key key;
+};
+
+// Журнал изменений формы дерева. По нему изменения повторяются на копии формы дерева (см. TreeReplay):
+// вставки и удаления — теми же алгоритмами, вращения — по ключу узла. Перестройки пачкой (bulkLoad,
+// insertBatch, clear) вращениями не выражаются и делают журнал неполным, как и превышение limit
+template <typename Key>
+struct TreeEventLog {
+    std::vector<TreeEvent<Key>> events;
+    std::size_t limit = std::numeric_limits<std::size_t>::max();  // Наибольшее число событий в журнале
+    bool complete = true;  // Все изменения с последнего clear записаны, журнал можно повторить
+
+    void record(typename TreeEvent<Key>::Kind kind, const Key& key) {
+        if (!complete) {
+            return;
+        }
+        if (events.size() == limit) {
+            invalidate();
+            return;
+        }
+        events.push_back({ kind, key });
+    }
+
+    // Функция для отметки, что изменения не записаны: события освобождаются, повторять их бессмысленно
+    void invalidate() {
+        events.clear();
+        complete = false;
+    }
+
+    void clear() {
+        events.clear();
+        complete = true;
+    }
+};
+
+// Порядок обхода для выгрузки ключей
+enum class TraversalOrder {
+    PreOrder,
+    InOrder,
+    PostOrder
+};
+
+// Бинарное дерево поиска с ключами типа Key, значениями типа Value (void — дерево-множество),
+// порядком Compare и распределителем памяти Allocator
+template <typename Key, typename Value = void, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>>
+class BinaryTree {
+public:
+    typedef TreeNode<Key, Value> Node;
+
+    // Двунаправленный итератор по узлам в порядке возрастания ключей, узлы доступны только для чтения.
+    // Узлы не хранят ссылок на родителей, поэтому итератор хранит путь от корня до текущего узла: шаг к соседнему
+    // узлу стоит O(1) в среднем за проход и O(высоты дерева) в худшем случае, копия итератора копирует путь.
+    // Итераторы всегда обходят дерево от члена root, а не от корня, переданного аргументом, как остальные функции.
+    // Любое изменение дерева (вставка, удаление, балансировка) делает итераторы недействительными
+    class Iterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef Node value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Node* pointer;
+        typedef const Node& reference;
+
+        Iterator() : tree(nullptr) {}
+        Iterator(const BinaryTree* tree, std::vector<Node*> ancestors) : tree(tree), ancestors(std::move(ancestors)) {}
+
+        const Node& operator*() const {
+            return *ancestors.back();
+        }
+
+        const Node* operator->() const {
+            return ancestors.back();
+        }
+
+        // Следующий узел — минимум правого поддерева, а без него — ближайший предок, в левом поддереве которого мы были
+        Iterator& operator++() {
+            Node* node = ancestors.back();
+            if (node->right != nullptr) {
+                descend(node->right, false);
+                return *this;
+            }
+            ascend(false);
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        // Шаг назад зеркален шагу вперёд; шаг назад от end() приводит к максимальному узлу
+        Iterator& operator--() {
+            if (ancestors.empty()) {
+                descend(tree->root, true);
+                return *this;
+            }
+            Node* node = ancestors.back();
+            if (node->left != nullptr) {
+                descend(node->left, true);
+                return *this;
+            }
+            ascend(true);
+            return *this;
+        }
+
+        Iterator operator--(int) {
+            Iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return current() == other.current();
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return current() != other.current();
+        }
+
+    private:
+        const BinaryTree* tree;
+        std::vector<Node*> ancestors;  // Путь от корня до текущего узла включительно, пустой для end()
+
+        Node* current() const {
+            return ancestors.empty() ? nullptr : ancestors.back();
+        }
+
+        // Спуск от node до крайнего левого (toRight = false) или крайнего правого узла его поддерева
+        void descend(Node* node, bool toRight) {
+            for (; node != nullptr; node = toRight ? node->right : node->left) {
+                ancestors.push_back(node);
+            }
+        }
+
+        // Подъём к ближайшему предку, в левом (fromRight = false) или правом поддереве которого лежит текущий узел.
+        // Если такого предка нет, путь пустеет и итератор становится end()
+        void ascend(bool fromRight) {
+            Node* child = ancestors.back();
+            ancestors.pop_back();
+            while (!ancestors.empty() && (fromRight ? ancestors.back()->left : ancestors.back()->right) == child) {
+                child = ancestors.back();
+                ancestors.pop_back();
+            }
+        }
+    };
+
+    Node* root;  // Указатель на корень дерева
+    bool autoBalance;  // Режим самобалансировки: вставка и удаление сразу поддерживают AVL-свойство
+    TreeEventLog<Key>* events;  // Журнал изменений формы или nullptr, если журнал не ведётся
+
+    // Конструктор бинарного дерева
+    explicit BinaryTree(bool autoBalance = false, const Compare& comp = Compare(), const Allocator& allocator = Allocator())
+        : comp(comp), pool(allocator) {
+        root = nullptr;  // При создании дерева корень равен nullptr
+        this->autoBalance = autoBalance;
+        events = nullptr;
+    }
+
+    // Деструктор: узлы разрушаются, память возвращается вместе с блоками пула
+    ~BinaryTree() {
+        clear();
+    }
+
+    BinaryTree(const BinaryTree&) = delete;
+    BinaryTree& operator=(const BinaryTree&) = delete;
+
+    // Перемещение передаёт узлы вместе с пулом, исходное дерево становится пустым
+    BinaryTree(BinaryTree&& other) noexcept
+        : root(other.root), autoBalance(other.autoBalance), events(other.events), comp(std::move(other.comp)), pool(std::move(other.pool)) {
+        other.root = nullptr;
+        other.events = nullptr;  // Журнал переходит к новому дереву, иначе исходное продолжило бы в него писать
+    }
+
+    BinaryTree& operator=(BinaryTree&& other) noexcept {
+        if (this != &other) {
+            clear();
+            pool = std::move(other.pool);
+            comp = std::move(other.comp);
+            root = other.root;
+            autoBalance = other.autoBalance;
+            events = other.events;
+            other.root = nullptr;
+            other.events = nullptr;
+        }
+        return *this;
+    }
+
+    // Функция для удаления всех узлов дерева
+    void clear() {
+        if (!std::is_trivially_destructible<Node>::value) {
+            destroySubtree(root);  // Ключи и значения с деструкторами разрушаем по одному
+        }
+        pool.release();
+        root = nullptr;
+        if (events != nullptr) {
+            events->invalidate();
+        }
+    }
+
+    // Функция для вставки узла в дерево (значение, если оно есть, создаётся по умолчанию)
+    Node* insert(Node* root, const Key& key) {
+        return emplace(root, key);
+    }
+
+    // Функция для вставки узла с ключом и значением, создаваемым на месте из args.
+    // Если ключ уже есть, дерево не меняется и аргументы не используются
+    template <typename K, typename... Args>
+    Node* emplace(Node* root, K&& key, Args&&... args) {
+        Node** link = &root;  // Ссылка, в которую будет подвешен новый узел
+        path.clear();
+
+        while (*link != nullptr) {
+            path.push_back(link);  // Запоминаем путь поиска для балансировки на обратном проходе
+            if (comp(key, (*link)->key)) {
+                link = &(*link)->left;  // Спускаемся в левое поддерево
+            }
+            else if (comp((*link)->key, key)) {
+                link = &(*link)->right;  // Спускаемся в правое поддерево
+            }
+            else {
+                BINARYTREE_COUNT(counters.duplicateInserts++);
+                return root;  // Ключ уже есть в дереве, форма дерева не изменилась
+            }
+        }
+        BINARYTREE_COUNT(counters.inserts++);
+        *link = pool.create(std::forward<K>(key), std::forward<Args>(args)...);  // Создание нового узла на месте пустой ссылки
+        record(TreeEvent<Key>::Insert, (*link)->key);
+        for (Node** ancestor : path) {
+            (*ancestor)->size++;  // Размеры всех поддеревьев на пути выросли на один узел
+        }
+
+        if (autoBalance) {
+            retrace();  // Балансируем узлы пути снизу вверх
+        }
+        return root;
+    }
+
+    // Функция для поиска минимального узла в дереве
+    Node* findMin(Node* node) const {
+        while (node != nullptr && node->left != nullptr) {
+            node = node->left;  // Проход по левым узлам для нахождения минимального узла
+        }
+        return node;
+    }
+
+    // Функция для поиска максимального узла в дереве
+    Node* findMax(Node* node) const {
+        while (node != nullptr && node->right != nullptr) {
+            node = node->right;  // Проход по правым узлам для нахождения максимального узла
+        }
+        return node;
+    }
+
+    // Функция для удаления узла из дерева
+    Node* deleteNode(Node* root, const Key& value) {
+        Node** link = &root;  // Ссылка на удаляемый узел
+        path.clear();
+
+        while (*link != nullptr && !equal((*link)->key, value)) {
+            path.push_back(link);  // Запоминаем путь поиска для балансировки на обратном проходе
+            link = comp(value, (*link)->key) ? &(*link)->left : &(*link)->right;
+        }
+        if (*link == nullptr) {
+            BINARYTREE_COUNT(counters.missedDeletes++);
+            return root;  // Значение не найдено, дерево не изменилось
+        }
+        BINARYTREE_COUNT(counters.deletes++);
+
+        Node* node = *link;
+        record(TreeEvent<Key>::Delete, node->key);
+        if (node->left != nullptr && node->right != nullptr) {
+            // Два потомка: на место узла переставляется минимальный узел правого поддерева.
+            // Узлы перевешиваются целиком, ключи и значения не копируются
+            BINARYTREE_COUNT(counters.twoChildDeletes++);
+            path.push_back(link);
+            std::size_t belowNode = path.size();
+            Node** minLink = &node->right;
+            while ((*minLink)->left != nullptr) {
+                path.push_back(minLink);
+                minLink = &(*minLink)->left;  // Спускаемся к минимальному узлу правого поддерева
+            }
+
+            Node* minNode = *minLink;
+            *minLink = minNode->right;  // Вынимаем минимальный узел, у него нет левого потомка
+            minNode->left = node->left;
+            minNode->right = node->right;
+            minNode->height = node->height;
+            minNode->size = node->size;
+            *link = minNode;
+            if (path.size() > belowNode) {
+                path[belowNode] = &minNode->right;  // Ссылка на правое поддерево теперь хранится в minNode
+            }
+        }
+        else {
+            *link = node->left != nullptr ? node->left : node->right;  // Подвешиваем единственного потомка на место узла
+        }
+        pool.destroy(node);
+        for (Node** ancestor : path) {
+            (*ancestor)->size--;  // Размеры всех поддеревьев на пути уменьшились на один узел
+        }
+
+        if (autoBalance) {
+            retrace();  // Балансируем узлы пути снизу вверх
+        }
+        return root;
+    }
+
+    // Функция для поиска узла с заданным значением в дереве
+    Node* search(Node* root, const Key& value) const {
+        BINARYTREE_COUNT(int length = root != nullptr ? 1 : 0);
+        while (root != nullptr && !equal(root->key, value)) {
+            root = comp(value, root->key) ? root->left : root->right;  // Спускаемся в левое поддерево, если значение меньше ключа текущего узла, иначе в правое
+            BINARYTREE_COUNT(length += root != nullptr ? 1 : 0);
+        }
+        BINARYTREE_COUNT(countSearch(length, root != nullptr));
+        return root;  // Возвращаем найденный узел или nullptr, если значения нет в дереве
+    }
+
+    // Функция для поиска узла с наибольшим ключом, меньшим key (предшественника), или nullptr
+    Node* predecessor(Node* root, const Key& key) const {
+        Node* result = nullptr;
+        while (root != nullptr) {
+            if (comp(root->key, key)) {
+                result = root;  // Подходящий узел, но справа могут быть ключи ближе к key
+                root = root->right;
+            }
+            else {
+                root = root->left;
+            }
+        }
+        return result;
+    }
+
+    // Функция для поиска узла с наименьшим ключом, большим key (преемника), или nullptr
+    Node* successor(Node* root, const Key& key) const {
+        Node* result = nullptr;
+        while (root != nullptr) {
+            if (comp(key, root->key)) {
+                result = root;  // Подходящий узел, но слева могут быть ключи ближе к key
+                root = root->left;
+            }
+            else {
+                root = root->right;
+            }
+        }
+        return result;
+    }
+
+    // Функция для обхода узлов с ключами из полуинтервала [from, to) в порядке возрастания.
+    // Посещаются только O(log n + k) узлов: поддеревья вне диапазона пропускаются целиком
+    template <typename Visitor>
+    void rangeQuery(Node* root, const Key& from, const Key& to, Visitor visit) const {
+        std::vector<Node*> stack;  // Предки с ключами не меньше from, ещё не посещённые
+        Node* node = root;
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                if (comp(node->key, from)) {
+                    node = node->right;  // Узел и его левое поддерево левее диапазона
+                }
+                else {
+                    stack.push_back(node);
+                    node = node->left;
+                }
+            }
+            if (stack.empty()) {
+                break;  // Оставшиеся ключи меньше from
+            }
+            node = stack.back();
+            stack.pop_back();
+            if (!comp(node->key, to)) {
+                break;  // Этот и все следующие ключи не меньше to
+            }
+            visit(node);
+            node = node->right;
+        }
+    }
+
+    // Итератор на наименьший узел дерева (или end(), если дерево пустое). Как и границы ниже, обходит дерево от члена root
+    Iterator begin() const {
+        std::vector<Node*> ancestors;
+        for (Node* node = root; node != nullptr; node = node->left) {
+            ancestors.push_back(node);
+        }
+        return Iterator(this, std::move(ancestors));
+    }
+
+    // Итератор за последним узлом
+    Iterator end() const {
+        return Iterator(this, std::vector<Node*>());
+    }
+
+    // Итератор на первый узел с ключом, не меньшим key
+    Iterator lowerBound(const Key& key) const {
+        return bound(key, false);
+    }
+
+    // Итератор на первый узел с ключом, большим key
+    Iterator upperBound(const Key& key) const {
+        return bound(key, true);
+    }
+
+    // Пара итераторов, ограничивающая узлы с ключом key (в дереве их не больше одного)
+    std::pair<Iterator, Iterator> equalRange(const Key& key) const {
+        Iterator first = lowerBound(key);
+        if (first != end() && !comp(key, first->key)) {
+            Iterator last = first;
+            return { first, ++last };
+        }
+        return { first, first };
+    }
+
+    // Функция для получения высоты узла в дереве
+    int getHeight(const Node* node) const {
+        if (node == nullptr) {
+            return 0;  // Возвращаем 0, если узел пустой
+        }
+        return node->height;
+    }
+
+    // Функция для получения снимка статистики: счётчики операций (при BINARYTREE_STATS), размер,
+    // фактическая и наименьшая возможная высота. Высота считается обходом за O(n), так как без
+    // автобалансировки высоты в узлах не поддерживаются. При measureHeight = false обход пропускается,
+    // и height остаётся нулём — для вызывающих, у которых высота уже известна
+    TreeStats stats(bool measureHeight = true) const {
+        TreeStats snapshot;
+#if defined(BINARYTREE_STATS)
+        snapshot = counters;
+#endif
+        snapshot.size = getSize(root);
+        std::vector<std::pair<const Node*, int>> stack;
+        if (root != nullptr && measureHeight) {
+            stack.push_back({ root, 1 });
+        }
+        while (!stack.empty()) {
+            std::pair<const Node*, int> top = stack.back();
+            stack.pop_back();
+            snapshot.height = std::max(snapshot.height, top.second);
+            if (top.first->left != nullptr) {
+                stack.push_back({ top.first->left, top.second + 1 });
+            }
+            if (top.first->right != nullptr) {
+                stack.push_back({ top.first->right, top.second + 1 });
+            }
+        }
+        for (std::size_t capacity = 0; capacity < snapshot.size; capacity = 2 * capacity + 1) {
+            snapshot.optimalHeight++;  // В дереве высоты h помещается не больше 2^h - 1 узлов
+        }
+        return snapshot;
+    }
+
+    // Функция для обнуления счётчиков операций
+    void resetStats() {
+#if defined(BINARYTREE_STATS)
+        counters = TreeStats();
+#endif
+    }
+
+    // Функция для получения памяти, занятой узлами дерева, в байтах (вместе со свободными местами пула)
+    std::size_t memoryUsage() const {
+        return pool.allocatedBytes();
+    }
+
+    // Функция для получения числа узлов в поддереве
+    std::size_t getSize(const Node* node) const {
+        if (node == nullptr) {
+            return 0;  // Возвращаем 0, если узел пустой
+        }
+        return node->size;
+    }
+
+    // Функция для обновления высоты и размера узла на основе его потомков.
+    // Её вызывают вращения и перестройки, поэтому размеры поддеревьев остаются верными при любой балансировке
+    void updateHeight(Node* node) {
+        if (node == nullptr) {
+            return;  // Ничего не делаем, если узел пустой
+        }
+        node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));  // Обновляем высоту узла
+        node->size = static_cast<std::uint32_t>(1 + getSize(node->left) + getSize(node->right));
+    }
+
+    // Функция для получения ранга ключа: числа ключей дерева, меньших key
+    std::size_t rank(Node* root, const Key& key) const {
+        std::size_t result = 0;
+        while (root != nullptr) {
+            if (comp(root->key, key)) {
+                result += getSize(root->left) + 1;  // Узел и всё его левое поддерево меньше key
+                root = root->right;
+            }
+            else {
+                root = root->left;
+            }
+        }
+        return result;
+    }
+
+    // Функция для поиска k-го по возрастанию узла (нумерация с нуля), nullptr, если k не меньше числа узлов
+    Node* select(Node* root, std::size_t k) const {
+        while (root != nullptr) {
+            std::size_t leftSize = getSize(root->left);
+            if (k < leftSize) {
+                root = root->left;
+            }
+            else if (k == leftSize) {
+                return root;
+            }
+            else {
+                k -= leftSize + 1;  // Пропускаем левое поддерево и сам узел
+                root = root->right;
+            }
+        }
+        return nullptr;
+    }
+
+    // Функция для подсчёта ключей в полуинтервале [from, to) без обхода самих ключей
+    std::size_t countInRange(Node* root, const Key& from, const Key& to) const {
+        if (!comp(from, to)) {
+            return 0;
+        }
+        return rank(root, to) - rank(root, from);
+    }
+
+    // Функция для преобразования дерева в AVL-дерево (балансировка)
+    Node* transformToAVL(Node* root) {
+        // Обратный обход с явным стеком: узел балансируется после того, как обработаны оба его поддерева
+        std::vector<std::pair<Node**, bool>> stack;  // Ссылка на узел и признак того, что его потомки уже в стеке
+        if (root != nullptr) {
+            stack.push_back({ &root, false });
+        }
+
+        while (!stack.empty()) {
+            Node** link = stack.back().first;
+            if (!stack.back().second) {
+                stack.back().second = true;
+                Node* node = *link;
+                if (node->right != nullptr) {
+                    stack.push_back({ &node->right, false });  // Правое поддерево будет обработано после левого
+                }
+                if (node->left != nullptr) {
+                    stack.push_back({ &node->left, false });
+                }
+            }
+            else {
+                stack.pop_back();
+                BINARYTREE_COUNT(std::uint64_t rotations = counters.leftRotations + counters.rightRotations);
+                *link = rebalance(*link);  // Оба поддерева уже преобразованы
+                BINARYTREE_COUNT(counters.transformRotations += counters.leftRotations + counters.rightRotations - rotations);
+            }
+        }
+
+        return root;  // Возвращаем корень преобразованного дерева
+    }
+
+    // Функция для восстановления AVL-свойства в узле, у которого поддеревья уже сбалансированы
+    Node* rebalance(Node* root) {
+        updateHeight(root);  // Обновляем высоту текущего узла
+
+        int balance = getHeight(root->left) - getHeight(root->right);  // Вычисляем баланс текущего узла
+
+        if (balance > 1) {  // Необходимо правое вращение
+            if (getHeight(root->left->right) > getHeight(root->left->left)) {
+                BINARYTREE_COUNT(counters.doubleRotations++);
+                root->left = leftRotate(root->left);  // Производим левое вращение для левого потомка
+            }
+            root = rightRotate(root);  // Правое вращение для текущего узла
+        }
+        else if (balance < -1) {  // Необходимо левое вращение
+            if (getHeight(root->right->left) > getHeight(root->right->right)) {
+                BINARYTREE_COUNT(counters.doubleRotations++);
+                root->right = rightRotate(root->right);  // Производим правое вращение для правого потомка
+            }
+            root = leftRotate(root);  // Левое вращение для текущего узла
+        }
+
+        return root;  // Возвращаем корень сбалансированного поддерева
+    }
+
+    // Функция для балансировки перестройкой (алгоритм Дэя — Стаута — Уоррена):
+    // дерево выпрямляется в упорядоченную "лозу" и сворачивается обратно в идеально сбалансированное.
+    // Работает за O(n) без рекурсии и без выделения памяти: переиспользуются существующие узлы
+    Node* rebuildBalanced(Node* root) {
+        BINARYTREE_COUNT(counters.rebuilds++);
+        int count = treeToVine(&root);  // Выпрямляем дерево в цепочку правых потомков
+        vineToTree(&root, count);  // Сворачиваем цепочку в сбалансированное дерево
+        return root;  // Возвращаем новый корень дерева
+    }
+
+    // Функция для построения дерева из последовательности ключей за O(n), если она упорядочена по возрастанию.
+    // Прежние узлы дерева удаляются, повторяющиеся ключи пропускаются. Неупорядоченная последовательность
+    // загружается через insertBatch. Узлы создаются в порядке ключей, поэтому лежат в пуле подряд
+    template <typename Iterator>
+    Node* bulkLoad(Iterator first, Iterator last) {
+        clear();
+        if (!std::is_sorted(first, last, comp)) {
+            return insertBatch(nullptr, first, last);
+        }
+        std::vector<Node*> nodes;
+        nodes.reserve(std::distance(first, last));
+        for (; first != last; ++first) {
+            if (nodes.empty() || comp(nodes.back()->key, *first)) {
+                nodes.push_back(pool.create(*first));
+            }
+        }
+        return linkBalanced(nodes);
+    }
+
+    // Функция для вставки пачки ключей в произвольном порядке. Вместо спуска от корня для каждого ключа
+    // пачка сортируется (параллельно) и сливается с симметричным обходом дерева за O(n + k),
+    // после чего узлы связываются в сбалансированное дерево. Существующие узлы сохраняются
+    template <typename Iterator>
+    Node* insertBatch(Node* root, Iterator first, Iterator last) {
+        std::vector<Key> keys(first, last);
+        if (!std::is_sorted(keys.begin(), keys.end(), comp)) {
+            parallelSort(keys, comp);
+        }
+
+        std::vector<Node*> nodes;  // Все узлы будущего дерева в порядке ключей
+        nodes.reserve(keys.size());
+        auto key = keys.begin();
+        auto append = [this, &nodes](const Key& newKey) {
+            if (nodes.empty() || comp(nodes.back()->key, newKey)) {
+                nodes.push_back(pool.create(newKey));  // Повторы внутри пачки пропускаются
+            }
+        };
+        inOrderTraversal(root, [&](Node* node) {
+            for (; key != keys.end() && comp(*key, node->key); ++key) {
+                append(*key);
+            }
+            while (key != keys.end() && !comp(node->key, *key)) {
+                ++key;  // Ключ уже есть в дереве, узел не меняется
+            }
+            nodes.push_back(node);
+        });
+        for (; key != keys.end(); ++key) {
+            append(*key);
+        }
+        return linkBalanced(nodes);
+    }
+
+    // Функция для выпрямления дерева в "лозу" правыми вращениями, возвращает число узлов
+    int treeToVine(Node** head) {
+        int count = 0;
+        Node** tail = head;  // Ссылка на корень ещё не обработанной части
+
+        while (*tail != nullptr) {
+            Node* rest = *tail;
+            if (rest->left == nullptr) {
+                rest->height = 1;  // Высоты пересчитываются при сворачивании
+                tail = &rest->right;  // Узел без левого потомка уже стоит на своём месте
+                count++;
+            }
+            else {
+                record(TreeEvent<Key>::RotateRight, rest->key);
+                Node* temp = rest->left;  // Правое вращение вокруг rest
+                rest->left = temp->right;
+                temp->right = rest;
+                *tail = temp;
+            }
+        }
+
+        return count;
+    }
+
+    // Функция для одного прохода сворачивания: count левых вращений через узел вдоль лозы
+    void compress(Node** head, int count) {
+        Node** scanner = head;
+
+        for (int i = 0; i < count; i++) {
+            Node* child = *scanner;
+            record(TreeEvent<Key>::RotateLeft, child->key);
+            Node* next = child->right;
+            child->right = next->left;
+            next->left = child;
+            *scanner = next;
+            updateHeight(child);  // Поддеревья child уже окончательные, его высота больше не изменится
+            scanner = &next->right;
+        }
+    }
+
+    // Функция для сворачивания лозы из count узлов в сбалансированное дерево
+    void vineToTree(Node** head, int count) {
+        int fullCount = 1;  // Размер наибольшего полного дерева, помещающегося в count узлов
+        while (fullCount * 2 <= count + 1) {
+            fullCount *= 2;
+        }
+        fullCount -= 1;
+
+        compress(head, count - fullCount);  // Выносим лишние узлы на нижний неполный уровень
+
+        for (int size = fullCount / 2; size > 0; size /= 2) {
+            compress(head, size);  // Каждый проход уменьшает длину лозы вдвое
+        }
+
+        // Узлы правой границы дерева остаются на лозе до конца и не проходят через compress,
+        // поэтому их высоты обновляем снизу вверх (длина границы не превышает log2(n) + 1)
+        Node* spine[64];
+        int spineLength = 0;
+        for (Node* node = *head; node != nullptr; node = node->right) {
+            spine[spineLength++] = node;
+        }
+        while (spineLength > 0) {
+            updateHeight(spine[--spineLength]);
+        }
+    }
+
+    Node* rightRotate(Node* y) {
+        BINARYTREE_COUNT(counters.rightRotations++);
+        record(TreeEvent<Key>::RotateRight, y->key);
+        Node* x = y->left;
+        Node* T2 = x->right;
+
+        x->right = y;  // Поворачиваем узлы
+        y->left = T2;  // Обновляем левое поддерево узла y
+
+        updateHeight(y);  // Обновляем высоту узла y
+        updateHeight(x);  // Обновляем высоту узла x
+
+        return x;  // Возвращаем новый корень поддерева
+    }
+
+    Node* leftRotate(Node* x) {
+        BINARYTREE_COUNT(counters.leftRotations++);
+        record(TreeEvent<Key>::RotateLeft, x->key);
+        Node* y = x->right;
+        Node* T2 = y->left;
+
+        y->left = x;  // Поворачиваем узлы
+        x->right = T2;  // Обновляем правое поддерево узла x
+
+        updateHeight(x);  // Обновляем высоту узла x
+        updateHeight(y);  // Обновляем высоту узла y
+
+        return y;  // Возвращаем новый корень поддерева
+    }
+
+    // Прямой обход (pre-order traversal) с вызовом visit для каждого узла
+    template <typename Visitor>
+    void preOrderTraversal(Node* root, Visitor visit) const {
+        std::vector<Node*> stack;
+        if (root != nullptr) {
+            stack.push_back(root);
+        }
+        while (!stack.empty()) {
+            Node* node = stack.back();
+            stack.pop_back();
+            visit(node);
+            if (node->right != nullptr) {
+                stack.push_back(node->right);  // Правое поддерево обходим после левого
+            }
+            if (node->left != nullptr) {
+                stack.push_back(node->left);
+            }
+        }
+    }
+
+    // Симметричный обход (in-order traversal) с вызовом visit для каждого узла
+    template <typename Visitor>
+    void inOrderTraversal(Node* root, Visitor visit) const {
+        std::vector<Node*> stack;
+        Node* node = root;
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                stack.push_back(node);  // Спускаемся по левым потомкам
+                node = node->left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            visit(node);
+            node = node->right;  // Переходим к правому поддереву
+        }
+    }
+
+    // Обратный обход (post-order traversal) с вызовом visit для каждого узла
+    template <typename Visitor>
+    void postOrderTraversal(Node* root, Visitor visit) const {
+        std::vector<Node*> stack;
+        Node* node = root;
+        Node* lastVisited = nullptr;  // Последний посещённый узел
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                stack.push_back(node);  // Спускаемся по левым потомкам
+                node = node->left;
+            }
+            Node* top = stack.back();
+            if (top->right != nullptr && top->right != lastVisited) {
+                node = top->right;  // Правое поддерево ещё не обойдено
+            }
+            else {
+                stack.pop_back();
+                visit(top);
+                lastVisited = top;
+            }
+        }
+    }
+
+    // Обход в порядке order с вызовом visit для каждого узла
+    template <typename Visitor>
+    void traverse(Node* root, TraversalOrder order, Visitor visit) const {
+        if (order == TraversalOrder::PreOrder) {
+            preOrderTraversal(root, visit);
+        }
+        else if (order == TraversalOrder::InOrder) {
+            inOrderTraversal(root, visit);
+        }
+        else {
+            postOrderTraversal(root, visit);
+        }
+    }
+
+    // Функция для выгрузки ключей в выходной итератор, возвращает итератор за последним ключом
+    template <typename OutputIt>
+    OutputIt copyKeys(Node* root, OutputIt out, TraversalOrder order = TraversalOrder::InOrder) const {
+        traverse(root, order, [&out](const Node* node) { *out++ = node->key; });
+        return out;
+    }
+
+    // Функция для выгрузки ключей текстом через separator. writer — BufferedWriter или любой std::ostream;
+    // для больших деревьев BufferedWriter во много раз быстрее, чем вывод каждого ключа в std::cout
+    template <typename Writer>
+    void writeKeys(Node* root, Writer& writer, TraversalOrder order = TraversalOrder::InOrder, char separator = ' ') const {
+        traverse(root, order, [&writer, separator](const Node* node) {
+            writer << node->key;
+            writer.put(separator);
+        });
+    }
+
+    // Параллельный обход: visit вызывается для каждого узла ровно один раз, в произвольном порядке
+    // и одновременно из нескольких потоков пула, поэтому должен быть потокобезопасным.
+    // Дерево в это время менять нельзя
+    template <typename Visitor>
+    void parallelForEach(Node* root, Visitor visit) const {
+        std::vector<Subtree> parts;
+        splitSubtrees(root, parts, [&visit](Node* node, std::size_t) { visit(node); });
+        ThreadPool::TaskGroup group;
+        for (const Subtree& part : parts) {
+            group.run([this, part, &visit] { preOrderTraversal(part.node, [&visit](Node* node) { visit(node); }); });
+        }
+        group.wait();
+    }
+
+    // Параллельная свёртка: значения map(node) всех узлов объединяются через combine, начиная с identity.
+    // Порядок объединения не определён, поэтому combine должна быть ассоциативной и коммутативной
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(Node* root, T identity, Map map, Combine combine) const {
+        struct alignas(64) Partial {  // Частичные результаты потоков не делят строку кэша
+            T value;
+        };
+        T result = identity;
+        std::vector<Subtree> parts;
+        splitSubtrees(root, parts, [&](Node* node, std::size_t) { result = combine(result, map(node)); });
+
+        std::vector<Partial> partials(parts.size(), Partial{ identity });
+        ThreadPool::TaskGroup group;
+        for (std::size_t i = 0; i < parts.size(); i++) {
+            group.run([&, i] {
+                T value = identity;
+                preOrderTraversal(parts[i].node, [&](Node* node) { value = combine(value, map(node)); });
+                partials[i].value = value;
+            });
+        }
+        group.wait();
+        for (const Partial& partial : partials) {
+            result = combine(result, partial.value);
+        }
+        return result;
+    }
+
+    // Параллельная выгрузка в порядке ключей: out[i] = transform(i-й по возрастанию узел).
+    // Место каждого поддерева в выходном массиве известно из размеров, поэтому части пишутся независимо.
+    // out должен вмещать getSize(root) элементов
+    template <typename RandomIt, typename Transform>
+    void parallelInOrder(Node* root, RandomIt out, Transform transform) const {
+        std::vector<Subtree> parts;
+        splitSubtrees(root, parts, [&](Node* node, std::size_t index) { out[index] = transform(node); });
+        ThreadPool::TaskGroup group;
+        for (const Subtree& part : parts) {
+            group.run([this, part, out, &transform] {
+                RandomIt position = out + part.offset;
+                inOrderTraversal(part.node, [&](Node* node) { *position++ = transform(node); });
+            });
+        }
+        group.wait();
+    }
+
+    // Параллельная выгрузка ключей в порядке возрастания
+    template <typename RandomIt>
+    void parallelInOrder(Node* root, RandomIt out) const {
+        parallelInOrder(root, out, [](const Node* node) { return node->key; });
+    }
+
+    // Функция для построения неизменяемого снимка ключей для быстрого поиска (см. FrozenTree).
+    // Дальнейшие изменения дерева можно передавать в снимок через его insert и erase
+    FrozenTree<Key, Compare> freeze() const {
+        std::vector<Key> keys;
+        inOrderTraversal(root, [&keys](const Node* node) { keys.push_back(node->key); });
+        FrozenTree<Key, Compare> snapshot(comp);
+        snapshot.build(keys.begin(), keys.end());
+        return snapshot;
+    }
+
+    // Прямой обход с печатью ключей
+    void preOrderTraversal(Node* root) {
+        BufferedWriter out;  // Печатаем значения блоками в стандартный вывод
+        writeKeys(root, out, TraversalOrder::PreOrder);
+    }
+
+    // Симметричный обход с печатью ключей
+    void inOrderTraversal(Node* root) {
+        BufferedWriter out;
+        writeKeys(root, out, TraversalOrder::InOrder);
+    }
+
+    // Обратный обход с печатью ключей
+    void postOrderTraversal(Node* root) {
+        BufferedWriter out;
+        writeKeys(root, out, TraversalOrder::PostOrder);
+    }
+
+    // Вертикальная печать
+    void printVertical(Node* root, int level = 0, char ch = ' ') {
+        // Обратный симметричный обход с явным стеком: правое поддерево печатается выше узла, левое ниже
+        struct Frame {
+            Node* node;
+            int level;
+            char ch;
+        };
+        std::vector<Frame> stack;
+        Frame current = { root, level, ch };
+
+        while (current.node != nullptr || !stack.empty()) {
+            while (current.node != nullptr) {
+                stack.push_back(current);
+                current = { current.node->right, current.level + 1, '/' };  // Сначала печатается правое поддерево
+            }
+            Frame frame = stack.back();
+            stack.pop_back();
+            for (int i = 0; i < frame.level; i++) {
+                std::cout << "   "; // Отступ для наглядности уровня узла в дереве
+            }
+            std::cout << frame.ch << "-- " << frame.node->key << std::endl; // Вывод узла с символом и ключом
+            current = { frame.node->left, frame.level + 1, '\\' };  // Затем левое поддерево
+        }
+    }
+
+    // Горизонтальная печать
+    void printHorizontal(const Node* root, const std::string& symbol = "", bool rootFlag = true, bool last = true) {
+        // Прямой обход с явным стеком, печатающий дерево с использованием символов для указания отношений между узлами
+        struct Frame {
+            const Node* node;
+            std::string symbol;
+            bool rootFlag;
+            bool last;
+        };
+        std::vector<Frame> stack = { { root, symbol, rootFlag, last } };
+
+        while (!stack.empty()) {
+            Frame frame = std::move(stack.back());
+            stack.pop_back();
+            std::cout << frame.symbol << (frame.rootFlag ? "" : (frame.last ? "+--" : "|--")); // Вывод символов для связей
+            if (frame.node) {
+                std::cout << frame.node->key;
+            }
+            std::cout << std::endl;
+            if (!frame.node) { continue; }
+
+            std::string childSymbol = frame.symbol + (frame.rootFlag ? "" : (frame.last ? "    " : "|   "));
+            stack.push_back({ frame.node->right, childSymbol, false, true });  // Правый потомок печатается последним
+            stack.push_back({ frame.node->left, childSymbol, false, false });
+        }
+    }
+
+private:
+    Compare comp;  // Порядок ключей
+    NodePool<Node, Allocator> pool;  // Пул, из которого выделяются все узлы дерева
+    std::vector<Node**> path;  // Путь поиска последней операции: ссылки на узлы от корня вниз
+#if defined(BINARYTREE_STATS)
+    mutable TreeStats counters;  // Счётчики меняются и в константных операциях поиска; дерево однопоточное
+
+    void countSearch(int length, bool hit) const {
+        counters.searches++;
+        counters.searchHits += hit;
+        counters.pathLengths[std::min(length, TreeStats::PathBuckets - 1)]++;
+    }
+#endif
+
+    // Функция для записи события в журнал, если он ведётся
+    void record(typename TreeEvent<Key>::Kind kind, const Key& key) {
+        if (events != nullptr) {
+            events->record(kind, key);
+        }
+    }
+
+    // Ключи равны, если ни один не меньше другого
+    bool equal(const Key& a, const Key& b) const {
+        return !comp(a, b) && !comp(b, a);
+    }
+
+    // Функция для спуска от корня к первому узлу с ключом, не меньшим key (upper = false) или большим key.
+    // Путь до найденного узла сохраняется в итераторе
+    Iterator bound(const Key& key, bool upper) const {
+        std::vector<Node*> ancestors;
+        std::size_t depth = 0;  // Длина пути до последнего подходящего узла
+        for (Node* node = root; node != nullptr;) {
+            ancestors.push_back(node);
+            if (upper ? !comp(key, node->key) : comp(node->key, key)) {
+                node = node->right;
+            }
+            else {
+                depth = ancestors.size();
+                node = node->left;
+            }
+        }
+        ancestors.resize(depth);
+        return Iterator(this, std::move(ancestors));
+    }
+
+    // Функция для балансировки узлов сохранённого пути поиска снизу вверх.
+    // Подъём прекращается, как только высота очередного поддерева не изменилась
+    void retrace() {
+        while (!path.empty()) {
+            Node** link = path.back();
+            path.pop_back();
+
+            int oldHeight = (*link)->height;
+            *link = rebalance(*link);
+            if ((*link)->height == oldHeight) {
+                break;  // Выше по пути высоты и балансы уже не меняются
+            }
+        }
+    }
+
+    // Поддерево, обрабатываемое одной задачей, и номер его наименьшего узла в симметричном порядке
+    struct Subtree {
+        Node* node;
+        std::size_t offset;
+    };
+
+    // Функция для разрезания дерева на поддеревья для задач пула. Размеры поддеревьев известны
+    // в каждом узле (в отличие от высот, они верны и без автобалансировки), поэтому узел, поддерево
+    // которого больше доли одной задачи, не уходит в задачу: его обрабатывает top(node, номер узла),
+    // а потомки режутся дальше. В parts поддеревья складываются слева направо
+    template <typename Top>
+    void splitSubtrees(Node* root, std::vector<Subtree>& parts, Top top) const {
+        const std::size_t TasksPerThread = 8;  // Запас задач, чтобы потоки могли перехватывать работу друг у друга
+        const std::size_t MinGrain = 1 << 14;  // Меньшие поддеревья дешевле обойти, чем поставить в очередь
+        std::size_t grain = std::max(MinGrain, getSize(root) / (TasksPerThread * ThreadPool::instance().size()));
+
+        std::vector<Subtree> stack;
+        if (root != nullptr) {
+            stack.push_back({ root, 0 });
+        }
+        while (!stack.empty()) {
+            Subtree part = stack.back();
+            stack.pop_back();
+            if (part.node->size <= grain) {
+                parts.push_back(part);
+                continue;
+            }
+            std::size_t index = part.offset + getSize(part.node->left);
+            top(part.node, index);
+            if (part.node->right != nullptr) {
+                stack.push_back({ part.node->right, index + 1 });  // Правое поддерево режется после левого
+            }
+            if (part.node->left != nullptr) {
+                stack.push_back({ part.node->left, part.offset });
+            }
+        }
+    }
+
+    // Функция для связывания упорядоченных узлов в сбалансированное дерево: средний узел отрезка становится
+    // корнем, половины — его поддеревьями. Отрезки обходятся симметрично с явным стеком, поэтому узлы
+    // перебираются в порядке массива. Высота поддерева из count узлов равна числу битов в count
+    Node* linkBalanced(const std::vector<Node*>& nodes) {
+        if (events != nullptr) {
+            events->invalidate();  // Связи всех узлов строятся заново, вращениями это не записать
+        }
+        struct Range {
+            Node** link;  // Ссылка, в которую подвешивается корень отрезка
+            std::size_t first;
+            std::size_t count;
+        };
+        Node* result = nullptr;
+        std::vector<Range> stack;
+        Range current = { &result, 0, nodes.size() };
+
+        while (current.count != 0 || !stack.empty()) {
+            while (current.count != 0) {
+                stack.push_back(current);
+                current = { &nodes[current.first + current.count / 2]->left, current.first, current.count / 2 };  // Левая половина
+            }
+            Range range = stack.back();
+            stack.pop_back();
+
+            std::size_t middle = range.first + range.count / 2;
+            Node* node = nodes[middle];
+            *range.link = node;
+            if (range.count / 2 == 0) {
+                node->left = nullptr;
+            }
+            node->right = nullptr;  // Будет перезаписан, когда дойдём до правой половины
+            node->size = static_cast<std::uint32_t>(range.count);
+            node->height = 0;
+            for (std::size_t count = range.count; count != 0; count >>= 1) {
+                node->height++;
+            }
+            current = { &node->right, middle + 1, range.count - range.count / 2 - 1 };  // Правая половина
+        }
+        return result;
+    }
+
+    // Функция для разрушения всех узлов поддерева без рекурсии
+    void destroySubtree(Node* node) {
+        std::vector<Node*> stack;
+        if (node != nullptr) {
+            stack.push_back(node);
+        }
+        while (!stack.empty()) {
+            Node* top = stack.back();
+            stack.pop_back();
+            if (top->left != nullptr) {
+                stack.push_back(top->left);
+            }
+            if (top->right != nullptr) {
+                stack.push_back(top->right);
+            }
+            pool.destroy(top);
+        }
+    }
+};
+
+#endif // BINARYTREE_H
@@ -0,0 +1,461 @@
+#ifndef BPLUSTREE_H
+#define BPLUSTREE_H
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// B+-дерево целых ключей для больших множеств в памяти.
+// Ключи узла занимают ровно одну строку кэша (16 ключей по 4 байта), поиск внутри узла —
+// сравнение всех 16 ключей сразу командами SSE2/AVX2 (или простым циклом без них).
+// Все ключи хранятся в листьях, листья связаны в список, поэтому обход и выборка диапазона
+// идут последовательно по памяти. Глубина дерева — log16(n), рекурсия в операциях неглубокая
+class BPlusTree {
+public:
+    static const int Capacity = 16;  // Ключей в узле: одна строка кэша
+    static const int MinKeys = Capacity / 2 - 1;  // Меньше этого узел сливается с соседом или занимает у него ключ
+
+    BPlusTree() {
+        root = nullptr;
+        count = 0;
+        levels = 0;
+    }
+
+    ~BPlusTree() {
+        clear();
+    }
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    // Функция для вставки ключа, возвращает false, если ключ уже был
+    bool insert(int key) {
+        if (root == nullptr) {
+            Leaf* leaf = new Leaf();
+            leaf->keys[0] = key;
+            leaf->count = 1;
+            root = leaf;
+            count = 1;
+            levels = 1;
+            return true;
+        }
+
+        Split split;
+        bool inserted = insertInto(root, key, split);
+        if (split.right != nullptr) {
+            Inner* newRoot = new Inner();  // Корень разделился: дерево растёт на уровень вверх
+            newRoot->keys[0] = split.separator;
+            newRoot->children[0] = root;
+            newRoot->children[1] = split.right;
+            newRoot->count = 1;
+            root = newRoot;
+            levels++;
+        }
+        if (inserted) {
+            count++;
+        }
+        return inserted;
+    }
+
+    // Функция для удаления ключа, возвращает false, если ключа не было
+    bool deleteNode(int key) {
+        if (root == nullptr || !eraseFrom(root, key)) {
+            return false;
+        }
+        count--;
+
+        if (root->count == 0) {
+            BNode* old = root;
+            if (old->leaf) {
+                root = nullptr;  // Удалён последний ключ
+                levels = 0;
+            }
+            else {
+                root = static_cast<Inner*>(old)->children[0];  // Корень без ключей: дерево теряет уровень
+                levels--;
+            }
+            destroyNode(old);
+        }
+        return true;
+    }
+
+    // Функция для поиска ключа
+    bool search(int key) const {
+        const BNode* node = root;
+        if (node == nullptr) {
+            return false;
+        }
+        while (!node->leaf) {
+            node = static_cast<const Inner*>(node)->children[childIndex(node, key)];
+        }
+        int position = countLess(node, key);
+        return position < node->count && node->keys[position] == key;
+    }
+
+    // Функция для поиска минимального ключа, возвращает nullptr для пустого дерева
+    const int* findMin() const {
+        const Leaf* leaf = firstLeaf();
+        return leaf != nullptr ? &leaf->keys[0] : nullptr;
+    }
+
+    // Симметричный обход: ключи по возрастанию, проход по списку листьев
+    template <typename Visitor>
+    void inOrderTraversal(Visitor visit) const {
+        for (const Leaf* leaf = firstLeaf(); leaf != nullptr; leaf = leaf->next) {
+            for (int i = 0; i < leaf->count; i++) {
+                visit(leaf->keys[i]);
+            }
+        }
+    }
+
+    // Функция для обхода ключей из полуинтервала [from, to) по возрастанию
+    template <typename Visitor>
+    void rangeScan(int from, int to, Visitor visit) const {
+        if (root == nullptr || from >= to) {
+            return;
+        }
+        const BNode* node = root;
+        while (!node->leaf) {
+            node = static_cast<const Inner*>(node)->children[childIndex(node, from)];
+        }
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        for (int i = countLess(leaf, from); leaf != nullptr; leaf = leaf->next, i = 0) {
+            for (; i < leaf->count; i++) {
+                if (leaf->keys[i] >= to) {
+                    return;
+                }
+                visit(leaf->keys[i]);
+            }
+        }
+    }
+
+    // Число ключей
+    std::size_t size() const {
+        return count;
+    }
+
+    // Число уровней дерева
+    int height() const {
+        return levels;
+    }
+
+    // Функция для удаления всех ключей
+    void clear() {
+        std::vector<BNode*> stack;
+        if (root != nullptr) {
+            stack.push_back(root);
+        }
+        while (!stack.empty()) {
+            BNode* node = stack.back();
+            stack.pop_back();
+            if (!node->leaf) {
+                Inner* inner = static_cast<Inner*>(node);
+                for (int i = 0; i <= inner->count; i++) {
+                    stack.push_back(inner->children[i]);
+                }
+            }
+            destroyNode(node);
+        }
+        root = nullptr;
+        count = 0;
+        levels = 0;
+    }
+
+private:
+    // Общая часть узла: ключи занимают первую строку кэша, неиспользуемые места заполнены INT_MAX
+    struct alignas(64) BNode {
+        int keys[Capacity];
+        int count;
+        bool leaf;
+
+        explicit BNode(bool leaf) : count(0), leaf(leaf) {
+            std::fill(keys, keys + Capacity, INT_MAX);
+        }
+    };
+
+    // Лист: ключи и ссылка на следующий лист
+    struct Leaf : BNode {
+        Leaf* next;
+
+        Leaf() : BNode(true), next(nullptr) {}
+    };
+
+    // Внутренний узел: count разделителей и count + 1 потомков.
+    // В потомке i ключи меньше keys[i], в потомке i + 1 — не меньше keys[i]
+    struct Inner : BNode {
+        BNode* children[Capacity + 1];
+
+        Inner() : BNode(false) {}
+    };
+
+    // Результат разделения переполненного узла: новый правый сосед и разделитель для родителя
+    struct Split {
+        int separator = 0;
+        BNode* right = nullptr;
+    };
+
+    BNode* root;
+    std::size_t count;
+    int levels;
+
+    // Число ключей узла, больших key (включая заполнители). Все 16 ключей сравниваются разом
+    static int countGreater(const BNode* node, int key) {
+#if defined(__AVX2__)
+        __m256i needle = _mm256_set1_epi32(key);
+        __m256i low = _mm256_load_si256(reinterpret_cast<const __m256i*>(node->keys));
+        __m256i high = _mm256_load_si256(reinterpret_cast<const __m256i*>(node->keys + 8));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(low, needle))))
+            | (static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(high, needle)))) << 8);
+        return popCount(mask);
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128i needle = _mm_set1_epi32(key);
+        unsigned mask = 0;
+        for (int i = 0; i < Capacity; i += 4) {
+            __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(node->keys + i));
+            mask |= static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, needle)))) << i;
+        }
+        return popCount(mask);
+#else
+        int greater = 0;
+        for (int i = 0; i < Capacity; i++) {
+            greater += node->keys[i] > key;
+        }
+        return greater;
+#endif
+    }
+
+    static int popCount(unsigned mask) {
+#if defined(__GNUC__)
+        return __builtin_popcount(mask);
+#else
+        int bits = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            bits++;
+        }
+        return bits;
+#endif
+    }
+
+    // Число ключей узла, не больших key. Заполнители INT_MAX отсекаются ограничением по count
+    static int countLessEqual(const BNode* node, int key) {
+        return std::min(Capacity - countGreater(node, key), node->count);
+    }
+
+    // Позиция первого ключа узла, не меньшего key
+    static int countLess(const BNode* node, int key) {
+        return key == INT_MIN ? 0 : countLessEqual(node, key - 1);
+    }
+
+    // Номер потомка, в поддереве которого может быть key
+    static int childIndex(const BNode* node, int key) {
+        return countLessEqual(node, key);
+    }
+
+    const Leaf* firstLeaf() const {
+        const BNode* node = root;
+        if (node == nullptr) {
+            return nullptr;
+        }
+        while (!node->leaf) {
+            node = static_cast<const Inner*>(node)->children[0];
+        }
+        return static_cast<const Leaf*>(node);
+    }
+
+    static void destroyNode(BNode* node) {
+        if (node->leaf) {
+            delete static_cast<Leaf*>(node);
+        }
+        else {
+            delete static_cast<Inner*>(node);
+        }
+    }
+
+    // Функция для вставки ключа в поддерево. Если узел переполнился, он делится пополам,
+    // и в split возвращаются правая половина и разделитель для родителя
+    bool insertInto(BNode* node, int key, Split& split) {
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int position = countLess(leaf, key);
+            if (position < leaf->count && leaf->keys[position] == key) {
+                return false;  // Ключ уже есть
+            }
+            if (leaf->count == Capacity) {
+                Leaf* right = new Leaf();  // Половина ключей уходит в новый лист справа
+                int half = Capacity / 2;
+                std::copy(leaf->keys + half, leaf->keys + Capacity, right->keys);
+                std::fill(leaf->keys + half, leaf->keys + Capacity, INT_MAX);
+                right->count = Capacity - half;
+                leaf->count = half;
+                right->next = leaf->next;
+                leaf->next = right;
+                split.separator = right->keys[0];
+                split.right = right;
+                if (position > half) {
+                    leaf = right;
+                    position -= half;
+                }
+            }
+            std::copy_backward(leaf->keys + position, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+            leaf->keys[position] = key;
+            leaf->count++;
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        int index = childIndex(inner, key);
+        Split childSplit;
+        bool inserted = insertInto(inner->children[index], key, childSplit);
+        if (childSplit.right == nullptr) {
+            return inserted;
+        }
+
+        if (inner->count < Capacity) {
+            insertSeparator(inner, index, childSplit.separator, childSplit.right);
+            return inserted;
+        }
+
+        // Узел полон: собираем 17 разделителей и 18 потомков, средний разделитель уходит к родителю
+        int keys[Capacity + 1];
+        BNode* children[Capacity + 2];
+        std::copy(inner->keys, inner->keys + index, keys);
+        keys[index] = childSplit.separator;
+        std::copy(inner->keys + index, inner->keys + Capacity, keys + index + 1);
+        std::copy(inner->children, inner->children + index + 1, children);
+        children[index + 1] = childSplit.right;
+        std::copy(inner->children + index + 1, inner->children + Capacity + 1, children + index + 2);
+
+        int half = Capacity / 2;
+        Inner* right = new Inner();
+        std::fill(inner->keys, inner->keys + Capacity, INT_MAX);
+        std::copy(keys, keys + half, inner->keys);
+        std::copy(children, children + half + 1, inner->children);
+        inner->count = half;
+        std::copy(keys + half + 1, keys + Capacity + 1, right->keys);
+        std::copy(children + half + 1, children + Capacity + 2, right->children);
+        right->count = Capacity - half;
+        split.separator = keys[half];
+        split.right = right;
+        return inserted;
+    }
+
+    // Функция для вставки разделителя и правого потомка после потомка index
+    static void insertSeparator(Inner* inner, int index, int separator, BNode* right) {
+        std::copy_backward(inner->keys + index, inner->keys + inner->count, inner->keys + inner->count + 1);
+        std::copy_backward(inner->children + index + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+        inner->keys[index] = separator;
+        inner->children[index + 1] = right;
+        inner->count++;
+    }
+
+    // Функция для удаления разделителя index и потомка справа от него
+    static void removeSeparator(Inner* inner, int index) {
+        std::copy(inner->keys + index + 1, inner->keys + inner->count, inner->keys + index);
+        std::copy(inner->children + index + 2, inner->children + inner->count + 1, inner->children + index + 1);
+        inner->count--;
+        inner->keys[inner->count] = INT_MAX;
+    }
+
+    // Функция для удаления ключа из поддерева. Узлы, в которых осталось меньше MinKeys ключей,
+    // исправляет родитель: занимает ключ у соседа или сливает их
+    bool eraseFrom(BNode* node, int key) {
+        if (node->leaf) {
+            int position = countLess(node, key);
+            if (position >= node->count || node->keys[position] != key) {
+                return false;
+            }
+            std::copy(node->keys + position + 1, node->keys + node->count, node->keys + position);
+            node->count--;
+            node->keys[node->count] = INT_MAX;
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        int index = childIndex(inner, key);
+        if (!eraseFrom(inner->children[index], key)) {
+            return false;
+        }
+        if (inner->children[index]->count < MinKeys) {
+            fixUnderflow(inner, index);
+        }
+        return true;
+    }
+
+    // Функция для исправления потомка index, в котором осталось слишком мало ключей
+    void fixUnderflow(Inner* parent, int index) {
+        int leftIndex = index > 0 ? index - 1 : index;  // Пара соседей: (leftIndex, leftIndex + 1)
+        BNode* left = parent->children[leftIndex];
+        BNode* right = parent->children[leftIndex + 1];
+
+        if (left->leaf) {
+            Leaf* leftLeaf = static_cast<Leaf*>(left);
+            Leaf* rightLeaf = static_cast<Leaf*>(right);
+            if (leftLeaf->count + rightLeaf->count <= Capacity) {
+                std::copy(rightLeaf->keys, rightLeaf->keys + rightLeaf->count, leftLeaf->keys + leftLeaf->count);
+                leftLeaf->count += rightLeaf->count;
+                leftLeaf->next = rightLeaf->next;
+                removeSeparator(parent, leftIndex);
+                delete rightLeaf;
+            }
+            else if (leftLeaf->count < rightLeaf->count) {
+                leftLeaf->keys[leftLeaf->count++] = rightLeaf->keys[0];  // Занимаем первый ключ правого соседа
+                std::copy(rightLeaf->keys + 1, rightLeaf->keys + rightLeaf->count, rightLeaf->keys);
+                rightLeaf->count--;
+                rightLeaf->keys[rightLeaf->count] = INT_MAX;
+                parent->keys[leftIndex] = rightLeaf->keys[0];
+            }
+            else {
+                std::copy_backward(rightLeaf->keys, rightLeaf->keys + rightLeaf->count, rightLeaf->keys + rightLeaf->count + 1);
+                rightLeaf->keys[0] = leftLeaf->keys[--leftLeaf->count];  // Занимаем последний ключ левого соседа
+                leftLeaf->keys[leftLeaf->count] = INT_MAX;
+                rightLeaf->count++;
+                parent->keys[leftIndex] = rightLeaf->keys[0];
+            }
+            return;
+        }
+
+        Inner* leftInner = static_cast<Inner*>(left);
+        Inner* rightInner = static_cast<Inner*>(right);
+        int separator = parent->keys[leftIndex];
+        if (leftInner->count + 1 + rightInner->count <= Capacity) {
+            // Слияние: разделитель родителя опускается между ключами соседей
+            leftInner->keys[leftInner->count] = separator;
+            std::copy(rightInner->keys, rightInner->keys + rightInner->count, leftInner->keys + leftInner->count + 1);
+            std::copy(rightInner->children, rightInner->children + rightInner->count + 1, leftInner->children + leftInner->count + 1);
+            leftInner->count += 1 + rightInner->count;
+            removeSeparator(parent, leftIndex);
+            delete rightInner;
+        }
+        else if (leftInner->count < rightInner->count) {
+            // Поворот влево: разделитель опускается в левый узел, первый ключ правого поднимается
+            leftInner->keys[leftInner->count] = separator;
+            leftInner->children[leftInner->count + 1] = rightInner->children[0];
+            leftInner->count++;
+            parent->keys[leftIndex] = rightInner->keys[0];
+            std::copy(rightInner->keys + 1, rightInner->keys + rightInner->count, rightInner->keys);
+            std::copy(rightInner->children + 1, rightInner->children + rightInner->count + 1, rightInner->children);
+            rightInner->count--;
+            rightInner->keys[rightInner->count] = INT_MAX;
+        }
+        else {
+            // Поворот вправо: разделитель опускается в правый узел, последний ключ левого поднимается
+            std::copy_backward(rightInner->keys, rightInner->keys + rightInner->count, rightInner->keys + rightInner->count + 1);
+            std::copy_backward(rightInner->children, rightInner->children + rightInner->count + 1, rightInner->children + rightInner->count + 2);
+            rightInner->keys[0] = separator;
+            rightInner->children[0] = leftInner->children[leftInner->count];
+            rightInner->count++;
+            parent->keys[leftIndex] = leftInner->keys[leftInner->count - 1];
+            leftInner->count--;
+            leftInner->keys[leftInner->count] = INT_MAX;
+        }
+    }
+};
+
+#endif // BPLUSTREE_H
@@ -0,0 +1,214 @@
+#ifndef BUFFEREDWRITER_H
+#define BUFFEREDWRITER_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Буферизованный вывод для выгрузки больших объёмов текста. Значения форматируются прямо в буфер
+// (целые — через std::to_chars, без локалей и потоков), а буфер уходит в файл одним системным вызовом
+// на блок. Вместо дескриптора можно передать sink: он получает блоки целиком, и значения между блоками
+// не разрываются
+class BufferedWriter {
+public:
+    // Запись в открытый дескриптор, по умолчанию в стандартный вывод
+    explicit BufferedWriter(int descriptor = 1, std::size_t capacity = 1 << 20)
+        : descriptor(descriptor), ownsDescriptor(false) {
+        allocate(capacity);
+        if (descriptor == 1 || descriptor == 2) {
+            std::cout.flush();  // Уже напечатанное через cout и stdio должно выйти раньше блоков writer
+            std::fflush(nullptr);
+        }
+    }
+
+    // Запись в файл path, файл создаётся или перезаписывается
+    explicit BufferedWriter(const std::string& path, std::size_t capacity = 1 << 20) : ownsDescriptor(true) {
+#if defined(_WIN32)
+        descriptor = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        descriptor = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+        if (descriptor < 0) {
+            throw std::runtime_error(path + ": cannot open for writing");
+        }
+        allocate(capacity);
+    }
+
+    // Запись через функцию sink(data, size), например в qDebug
+    explicit BufferedWriter(std::function<void(const char*, std::size_t)> sink, std::size_t capacity = 1 << 16)
+        : descriptor(-1), ownsDescriptor(false), sink(std::move(sink)) {
+        allocate(capacity);
+    }
+
+    ~BufferedWriter() {
+        flush();
+        if (ownsDescriptor) {
+#if defined(_WIN32)
+            _close(descriptor);
+#else
+            ::close(descriptor);
+#endif
+        }
+    }
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    // Функция для записи size байт. Блок больше буфера уходит вместе с содержимым буфера одним writev
+    BufferedWriter& write(const char* data, std::size_t size) {
+        if (size <= capacity - used) {
+            std::memcpy(buffer.get() + used, data, size);
+            used += size;
+        }
+        else if (size < capacity) {
+            flush();
+            std::memcpy(buffer.get(), data, size);
+            used = size;
+        }
+        else {
+            send(data, size);
+        }
+        return *this;
+    }
+
+    BufferedWriter& put(char symbol) {
+        if (used == capacity) {
+            flush();
+        }
+        buffer[used++] = symbol;
+        return *this;
+    }
+
+    BufferedWriter& operator<<(const char* text) {
+        return write(text, std::strlen(text));
+    }
+
+    BufferedWriter& operator<<(const std::string& text) {
+        return write(text.data(), text.size());
+    }
+
+    BufferedWriter& operator<<(char symbol) {
+        return put(symbol);
+    }
+
+    // Запись значения: целые форматируются без промежуточных строк, прочие типы — через их operator<<
+    template <typename T>
+    BufferedWriter& operator<<(const T& value) {
+        if constexpr (std::is_integral<T>::value && !std::is_same<T, bool>::value) {
+            if (capacity - used < MaxNumberLength) {
+                flush();
+            }
+            char* end = std::to_chars(buffer.get() + used, buffer.get() + capacity, value).ptr;
+            used = static_cast<std::size_t>(end - buffer.get());
+        }
+        else {
+            std::ostringstream text;
+            text << value;
+            *this << text.str();
+        }
+        return *this;
+    }
+
+    // Функция для отправки накопленного буфера, возвращает false, если запись в файл не удалась
+    bool flush() {
+        if (used != 0) {
+            send(nullptr, 0);
+        }
+        return !failed;
+    }
+
+    bool good() const {
+        return !failed;
+    }
+
+private:
+    static constexpr std::size_t MaxNumberLength = 40;  // Длиннее любого целого, включая 128-битные со знаком
+
+    int descriptor;
+    bool ownsDescriptor;
+    std::function<void(const char*, std::size_t)> sink;
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity = 0;
+    std::size_t used = 0;
+    bool failed = false;
+
+    void allocate(std::size_t size) {
+        capacity = size > MaxNumberLength ? size : MaxNumberLength;
+        buffer.reset(new char[capacity]);
+    }
+
+    // Функция для отправки буфера и следом блока extra одной операцией, буфер после неё пуст
+    void send(const char* extra, std::size_t extraSize) {
+        if (sink) {
+            if (used != 0) {
+                sink(buffer.get(), used);
+            }
+            if (extraSize != 0) {
+                sink(extra, extraSize);
+            }
+            used = 0;
+            return;
+        }
+#if defined(_WIN32)
+        failed = failed || !writeAll(buffer.get(), used) || !writeAll(extra, extraSize);
+#else
+        struct iovec parts[2] = { { buffer.get(), used }, { const_cast<char*>(extra), extraSize } };
+        struct iovec* part = parts;
+        int count = extraSize != 0 ? 2 : 1;
+        while (count > 0 && !failed) {
+            ssize_t written = ::writev(descriptor, part, count);
+            if (written < 0) {
+                failed = true;
+                break;
+            }
+            // Частичная запись: пропускаем записанное и повторяем с остатка
+            std::size_t done = static_cast<std::size_t>(written);
+            while (count > 0 && done >= part->iov_len) {
+                done -= part->iov_len;
+                part++;
+                count--;
+            }
+            if (count > 0) {
+                part->iov_base = static_cast<char*>(part->iov_base) + done;
+                part->iov_len -= done;
+            }
+        }
+#endif
+        used = 0;
+    }
+
+#if defined(_WIN32)
+    bool writeAll(const char* data, std::size_t size) {
+        while (size > 0) {
+            unsigned chunk = size < (1u << 30) ? static_cast<unsigned>(size) : (1u << 30);
+            int written = _write(descriptor, data, chunk);
+            if (written <= 0) {
+                return false;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+#endif
+};
+
+#endif // BUFFEREDWRITER_H
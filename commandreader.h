@@ -0,0 +1,161 @@
+#ifndef COMMANDREADER_H
+#define COMMANDREADER_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Построчное чтение команд из файла или стандартного ввода без копирования: вход читается крупными
+// блоками, а слова строки возвращаются как string_view прямо в буфер блока. Слова разделяются пробелами,
+// табуляциями и запятыми, всё после '#' — комментарий. Слова действительны до следующего вызова next
+class CommandReader {
+public:
+    // Чтение из открытого дескриптора, по умолчанию из стандартного ввода
+    explicit CommandReader(int descriptor = 0, std::size_t capacity = 1 << 20)
+        : descriptor(descriptor), ownsDescriptor(false) {
+        allocate(capacity);
+    }
+
+    // Чтение из файла path
+    explicit CommandReader(const std::string& path, std::size_t capacity = 1 << 20) : ownsDescriptor(true) {
+#if defined(_WIN32)
+        descriptor = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+        descriptor = ::open(path.c_str(), O_RDONLY);
+#endif
+        if (descriptor < 0) {
+            throw std::runtime_error(path + ": cannot open for reading");
+        }
+        allocate(capacity);
+    }
+
+    ~CommandReader() {
+        if (ownsDescriptor) {
+#if defined(_WIN32)
+            _close(descriptor);
+#else
+            ::close(descriptor);
+#endif
+        }
+    }
+
+    CommandReader(const CommandReader&) = delete;
+    CommandReader& operator=(const CommandReader&) = delete;
+
+    // Функция для чтения следующей непустой строки в tokens, возвращает false в конце ввода
+    bool next(std::vector<std::string_view>& tokens) {
+        while (true) {
+            tokens.clear();
+            const char* line = buffer.get() + begin;
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - begin));
+            if (newline == nullptr && !finished) {
+                refill();
+                continue;
+            }
+            const char* lineEnd = newline != nullptr ? newline : buffer.get() + end;
+            if (newline == nullptr && line == lineEnd) {
+                return false;
+            }
+            begin = static_cast<std::size_t>(lineEnd - buffer.get()) + (newline != nullptr ? 1 : 0);
+            lineNumber++;
+            split(line, lineEnd, tokens);
+            if (!tokens.empty()) {
+                return true;
+            }
+        }
+    }
+
+    // Номер последней прочитанной строки, начиная с 1
+    std::size_t line() const {
+        return lineNumber;
+    }
+
+private:
+    int descriptor;
+    bool ownsDescriptor;
+    std::unique_ptr<char[]> buffer;
+    std::size_t capacity = 0;
+    std::size_t begin = 0;  // Начало непрочитанной части буфера
+    std::size_t end = 0;  // Конец прочитанных из файла данных
+    std::size_t lineNumber = 0;
+    bool finished = false;
+
+    void allocate(std::size_t size) {
+        capacity = size > 16 ? size : 16;
+        buffer.reset(new char[capacity]);
+    }
+
+    // Функция для дочитывания блока: непрочитанный хвост переносится в начало буфера,
+    // а если строка не помещается в буфер целиком, буфер удваивается
+    void refill() {
+        std::size_t rest = end - begin;
+        if (rest == capacity) {
+            std::unique_ptr<char[]> larger(new char[capacity * 2]);
+            std::memcpy(larger.get(), buffer.get() + begin, rest);
+            buffer.swap(larger);
+            capacity *= 2;
+        }
+        else if (begin != 0) {
+            std::memmove(buffer.get(), buffer.get() + begin, rest);
+        }
+        begin = 0;
+        end = rest;
+#if defined(_WIN32)
+        int bytes = _read(descriptor, buffer.get() + end, static_cast<unsigned>(capacity - end));
+#else
+        long bytes = ::read(descriptor, buffer.get() + end, capacity - end);
+#endif
+        if (bytes <= 0) {
+            finished = true;
+        }
+        else {
+            end += static_cast<std::size_t>(bytes);
+        }
+    }
+
+    static bool isSeparator(char symbol) {
+        return symbol == ' ' || symbol == '\t' || symbol == ',' || symbol == '\r';
+    }
+
+    static void split(const char* position, const char* lineEnd, std::vector<std::string_view>& tokens) {
+        while (position != lineEnd && *position != '#') {
+            if (isSeparator(*position)) {
+                position++;
+                continue;
+            }
+            const char* token = position;
+            while (position != lineEnd && !isSeparator(*position) && *position != '#') {
+                position++;
+            }
+            tokens.emplace_back(token, static_cast<std::size_t>(position - token));
+        }
+    }
+};
+
+// Функция для разбора числа из слова целиком, возвращает false, если слово — не число типа T
+template <typename T>
+bool parseToken(std::string_view token, T& value) {
+    const char* first = token.data();
+    const char* last = first + token.size();
+    if (first != last && *first == '+') {
+        first++;  // from_chars не принимает явный плюс
+    }
+    std::from_chars_result result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr == last && first != last;
+}
+
+#endif // COMMANDREADER_H
@@ -0,0 +1,339 @@
+#ifndef COMPACTTREE_H
+#define COMPACTTREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Компактный узел: ключ и два 32-битных индекса потомков.
+// Старшие 3 бита каждого индекса хранят половину высоты узла (всего 6 бит, высота до 63),
+// поэтому узел занимает 12 байт вместо 24 у узла с указателями
+struct CompactNode {
+    int key;
+    std::uint32_t child[2];  // Индексы левого и правого потомков; старшие биты child[0] — младшая половина высоты, child[1] — старшая
+};
+
+static_assert(sizeof(CompactNode) == 12, "CompactNode must stay 12 bytes");
+
+// Дерево поиска с узлами в непрерывном массиве, с тем же набором операций, что и BinaryTree.
+// Вместо указателей используются индексы, индекс 0 означает отсутствие узла
+class CompactTree {
+public:
+    typedef std::uint32_t Index;
+
+    static const Index Null = 0;  // Пустая ссылка, узел с этим индексом имеет высоту 0
+    static const Index MaxNodes = (1u << 29) - 1;  // Индекс занимает 29 бит
+
+    Index root;  // Индекс корня дерева
+    bool autoBalance;  // Режим самобалансировки, как в BinaryTree
+
+    // Конструктор компактного дерева
+    CompactTree(bool autoBalance = false) {
+        root = Null;
+        this->autoBalance = autoBalance;
+        freeList = Null;
+        nodes.push_back({ 0, { 0, 0 } });  // Нулевой элемент зарезервирован под пустую ссылку
+    }
+
+    // Функция для получения ключа узла
+    int key(Index node) const {
+        return nodes[node].key;
+    }
+
+    Index left(Index node) const {
+        return nodes[node].child[0] & IndexMask;
+    }
+
+    Index right(Index node) const {
+        return nodes[node].child[1] & IndexMask;
+    }
+
+    // Функция для получения высоты узла, для пустой ссылки возвращается 0
+    int getHeight(Index node) const {
+        return (nodes[node].child[0] >> IndexBits) | ((nodes[node].child[1] >> IndexBits) << HalfHeightBits);
+    }
+
+    // Функция для вставки узла в дерево
+    Index insert(Index root, int key) {
+        path.clear();
+        Index parent = Null;
+        bool toRight = false;
+
+        for (Index node = root; node != Null; node = toRight ? right(node) : left(node)) {
+            if (key == nodes[node].key) {
+                return root;  // Ключ уже есть в дереве, форма дерева не изменилась
+            }
+            parent = node;
+            toRight = key > nodes[node].key;
+            path.push_back({ node, toRight });  // Запоминаем путь поиска и направление спуска
+        }
+
+        Index created = allocate(key);
+        if (parent == Null) {
+            return created;  // Дерево было пустым
+        }
+        setChild(parent, toRight, created);
+
+        if (autoBalance) {
+            root = retrace(root);  // Балансируем узлы пути снизу вверх
+        }
+        return root;
+    }
+
+    // Функция для поиска минимального узла в дереве
+    Index findMin(Index node) const {
+        while (left(node) != Null) {
+            node = left(node);  // Проход по левым узлам для нахождения минимального узла
+        }
+        return node;
+    }
+
+    // Функция для удаления узла из дерева
+    Index deleteNode(Index root, int value) {
+        path.clear();
+        Index node = root;
+
+        while (node != Null && nodes[node].key != value) {
+            bool toRight = value > nodes[node].key;
+            path.push_back({ node, toRight });
+            node = toRight ? right(node) : left(node);
+        }
+        if (node == Null) {
+            return root;  // Значение не найдено, дерево не изменилось
+        }
+
+        if (left(node) != Null && right(node) != Null) {
+            path.push_back({ node, true });
+            Index minNode = right(node);
+            while (left(minNode) != Null) {
+                path.push_back({ minNode, false });
+                minNode = left(minNode);  // Спускаемся к минимальному узлу правого поддерева
+            }
+            nodes[node].key = nodes[minNode].key;  // Замена удаляемого ключа минимальным ключом из правого поддерева
+            node = minNode;  // Физически удаляется узел с минимальным ключом, у него нет левого потомка
+        }
+
+        Index child = left(node) != Null ? left(node) : right(node);
+        release(node);
+
+        if (path.empty()) {
+            return child;  // Удалялся корень
+        }
+        setChild(path.back().node, path.back().toRight, child);
+
+        if (autoBalance) {
+            root = retrace(root);  // Балансируем узлы пути снизу вверх
+        }
+        return root;
+    }
+
+    // Функция для поиска узла с заданным значением в дереве
+    Index search(Index root, int value) const {
+        const CompactNode* data = nodes.data();
+        while (root != Null && data[root].key != value) {
+            const CompactNode& node = data[root];
+            root = node.child[value > node.key] & IndexMask;  // Выбор потомка без ветвления по результату сравнения
+        }
+        return root;  // Возвращаем найденный узел или Null, если значения нет в дереве
+    }
+
+    // Прямой обход (pre-order traversal)
+    void preOrderTraversal(Index root) const {
+        std::vector<Index> stack;
+        if (root != Null) {
+            stack.push_back(root);
+        }
+        while (!stack.empty()) {
+            Index node = stack.back();
+            stack.pop_back();
+            std::cout << nodes[node].key << " ";  // Печатаем значение узла
+            if (right(node) != Null) {
+                stack.push_back(right(node));  // Правое поддерево обходим после левого
+            }
+            if (left(node) != Null) {
+                stack.push_back(left(node));
+            }
+        }
+    }
+
+    // Симметричный обход (in-order traversal)
+    void inOrderTraversal(Index root) const {
+        std::vector<Index> stack;
+        Index node = root;
+        while (node != Null || !stack.empty()) {
+            while (node != Null) {
+                stack.push_back(node);  // Спускаемся по левым потомкам
+                node = left(node);
+            }
+            node = stack.back();
+            stack.pop_back();
+            std::cout << nodes[node].key << " ";  // Печатаем значение узла
+            node = right(node);  // Переходим к правому поддереву
+        }
+    }
+
+    // Обратный обход (post-order traversal)
+    void postOrderTraversal(Index root) const {
+        std::vector<Index> stack;
+        Index node = root;
+        Index lastVisited = Null;  // Последний напечатанный узел
+        while (node != Null || !stack.empty()) {
+            while (node != Null) {
+                stack.push_back(node);  // Спускаемся по левым потомкам
+                node = left(node);
+            }
+            Index top = stack.back();
+            if (right(top) != Null && right(top) != lastVisited) {
+                node = right(top);  // Правое поддерево ещё не обойдено
+            }
+            else {
+                stack.pop_back();
+                std::cout << nodes[top].key << " ";  // Печатаем значение узла
+                lastVisited = top;
+            }
+        }
+    }
+
+    // Функция для удаления всех узлов дерева
+    void clear() {
+        nodes.resize(1);
+        nodes.shrink_to_fit();
+        freeList = Null;
+        root = Null;
+    }
+
+    // Функция для получения объёма памяти, занятого массивом узлов, в байтах
+    std::size_t memoryUsage() const {
+        return nodes.capacity() * sizeof(CompactNode);
+    }
+
+private:
+    static const int IndexBits = 29;
+    static const int HalfHeightBits = 3;
+    static const std::uint32_t IndexMask = (1u << IndexBits) - 1;
+
+    // Элемент пути поиска: узел и направление, в котором из него спустились
+    struct PathEntry {
+        Index node;
+        bool toRight;
+    };
+
+    std::vector<CompactNode> nodes;  // Все узлы дерева, нулевой элемент не используется
+    std::vector<PathEntry> path;  // Путь поиска последней операции
+    Index freeList;  // Голова списка освободившихся элементов, связанных через child[0]
+
+    void setLeft(Index node, Index child) {
+        nodes[node].child[0] = (nodes[node].child[0] & ~IndexMask) | child;
+    }
+
+    void setRight(Index node, Index child) {
+        nodes[node].child[1] = (nodes[node].child[1] & ~IndexMask) | child;
+    }
+
+    void setChild(Index node, bool toRight, Index child) {
+        if (toRight) {
+            setRight(node, child);
+        }
+        else {
+            setLeft(node, child);
+        }
+    }
+
+    void setHeight(Index node, int height) {
+        std::uint32_t low = height & ((1u << HalfHeightBits) - 1);
+        std::uint32_t high = height >> HalfHeightBits;
+        nodes[node].child[0] = (nodes[node].child[0] & IndexMask) | (low << IndexBits);
+        nodes[node].child[1] = (nodes[node].child[1] & IndexMask) | (high << IndexBits);
+    }
+
+    // Функция для выделения элемента под новый узел: из списка свободных или в конце массива
+    Index allocate(int key) {
+        Index node;
+        if (freeList != Null) {
+            node = freeList;
+            freeList = nodes[node].child[0];
+        }
+        else {
+            if (nodes.size() > MaxNodes) {
+                throw std::length_error("CompactTree: too many nodes");
+            }
+            node = static_cast<Index>(nodes.size());
+            nodes.push_back({ 0, { 0, 0 } });
+        }
+        nodes[node] = { key, { 0, 0 } };
+        setHeight(node, 1);  // При создании узла, его высота равна 1
+        return node;
+    }
+
+    // Функция для возврата элемента в список свободных
+    void release(Index node) {
+        nodes[node].child[0] = freeList;
+        nodes[node].child[1] = 0;
+        freeList = node;
+    }
+
+    void updateHeight(Index node) {
+        setHeight(node, 1 + std::max(getHeight(left(node)), getHeight(right(node))));
+    }
+
+    Index rightRotate(Index y) {
+        Index x = left(y);
+        setLeft(y, right(x));
+        setRight(x, y);
+        updateHeight(y);
+        updateHeight(x);
+        return x;
+    }
+
+    Index leftRotate(Index x) {
+        Index y = right(x);
+        setRight(x, left(y));
+        setLeft(y, x);
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    // Функция для восстановления AVL-свойства в узле, у которого поддеревья уже сбалансированы
+    Index rebalance(Index node) {
+        updateHeight(node);
+        int balance = getHeight(left(node)) - getHeight(right(node));
+
+        if (balance > 1) {
+            if (getHeight(right(left(node))) > getHeight(left(left(node)))) {
+                setLeft(node, leftRotate(left(node)));
+            }
+            node = rightRotate(node);
+        }
+        else if (balance < -1) {
+            if (getHeight(left(right(node))) > getHeight(right(right(node)))) {
+                setRight(node, rightRotate(right(node)));
+            }
+            node = leftRotate(node);
+        }
+        return node;
+    }
+
+    // Функция для балансировки узлов сохранённого пути снизу вверх, возвращает новый корень
+    Index retrace(Index root) {
+        while (!path.empty()) {
+            PathEntry entry = path.back();
+            path.pop_back();
+
+            int oldHeight = getHeight(entry.node);
+            Index subtree = rebalance(entry.node);
+            if (path.empty()) {
+                return subtree;  // Перебалансирован корень
+            }
+            setChild(path.back().node, path.back().toRight, subtree);
+            if (getHeight(subtree) == oldHeight) {
+                break;  // Выше по пути высоты и балансы уже не меняются
+            }
+        }
+        return root;
+    }
+};
+
+#endif // COMPACTTREE_H
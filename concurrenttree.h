@@ -0,0 +1,616 @@
+#ifndef CONCURRENTTREE_H
+#define CONCURRENTTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "binarytree.h"
+
+// Домен эпох для безопасного освобождения узлов (epoch-based reclamation), общий для всех
+// конкурентных деревьев процесса. Читатель на время операции объявляет в своём слоте текущую эпоху.
+// Узел, отцепленный от дерева в эпоху e, освобождается, когда глобальная эпоха дошла до e + 2:
+// эпоха сдвигается, только если все активные читатели уже в ней, поэтому читателей, видевших узел, не осталось
+class EpochDomain {
+    // Слот потока занимает отдельную строку кэша, чтобы читатели не мешали друг другу
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch;  // Объявленная эпоха или Idle
+        std::atomic<bool> used;  // Слот закреплён за живым потоком
+    };
+
+public:
+    static const int MaxThreads = 256;  // Число одновременно живых потоков, читающих конкурентные деревья
+    static const std::uint64_t Idle = 0;  // Поток сейчас не читает
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    // Защита читателя: пока объект жив, узлы, которые поток может увидеть, не освобождаются
+    class Guard {
+    public:
+        Guard() : slot(instance().threadSlot()) {
+            slot.epoch.store(instance().global.load(std::memory_order_relaxed), std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);  // Объявление видно до первого чтения узлов
+        }
+
+        ~Guard() {
+            slot.epoch.store(Idle, std::memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        Slot& slot;
+    };
+
+    // Текущая эпоха, ею помечаются отцепленные узлы
+    std::uint64_t current() const {
+        return global.load(std::memory_order_acquire);
+    }
+
+    // Функция для попытки перейти к следующей эпохе, возвращает эпоху после попытки.
+    // Переход невозможен, пока хотя бы один читатель остаётся в предыдущей эпохе
+    std::uint64_t tryAdvance() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::uint64_t epoch = global.load(std::memory_order_relaxed);
+        int count = slotCount.load(std::memory_order_acquire);
+        for (int i = 0; i < count; i++) {
+            // Захват синхронизирует с освобождением слота: чтения узлов читателем завершились до их освобождения
+            std::uint64_t seen = slots[i].epoch.load(std::memory_order_acquire);
+            if (seen != Idle && seen != epoch) {
+                return epoch;
+            }
+        }
+        global.compare_exchange_strong(epoch, epoch + 1, std::memory_order_acq_rel);
+        return global.load(std::memory_order_acquire);
+    }
+
+private:
+    Slot slots[MaxThreads];
+    std::atomic<int> slotCount;  // Число слотов, которые когда-либо выдавались: дальше проверять не нужно
+    std::atomic<std::uint64_t> global;
+
+    EpochDomain() : slotCount(0), global(1) {
+        for (Slot& slot : slots) {
+            slot.epoch.store(Idle, std::memory_order_relaxed);
+            slot.used.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Закрепление слота за потоком: слот выдаётся при первом чтении и возвращается при завершении потока
+    struct SlotOwner {
+        int index;
+
+        SlotOwner() {
+            EpochDomain& domain = instance();
+            for (index = 0; index < MaxThreads; index++) {
+                if (!domain.slots[index].used.exchange(true, std::memory_order_acq_rel)) {
+                    break;
+                }
+            }
+            if (index == MaxThreads) {
+                throw std::length_error("EpochDomain: too many threads");
+            }
+            int count = domain.slotCount.load(std::memory_order_relaxed);
+            while (count <= index && !domain.slotCount.compare_exchange_weak(count, index + 1, std::memory_order_acq_rel)) {
+            }
+        }
+
+        ~SlotOwner() {
+            instance().slots[index].used.store(false, std::memory_order_release);
+        }
+    };
+
+    Slot& threadSlot() {
+        thread_local SlotOwner owner;
+        return slots[owner.index];
+    }
+};
+
+// Потокобезопасное AVL-дерево-множество. Ключи распределяются по шардам (независимым деревьям) по хешу,
+// поэтому нагрузка ровная при любом распределении ключей. Упорядоченные запросы (findMin, findMax, predecessor,
+// successor, rangeQuery, inOrderTraversal) спрашивают каждый шард и сливают ответы: границы стоят O(шардов · log n),
+// обход k ключей — O(шардов · log n + k log шардов) и копирует эти ключи. При одновременных изменениях ответ
+// согласован внутри каждого шарда, а ключи, которые меняются во время запроса, могут в него попасть или нет.
+// rank/select и позиционных итераторов нет: для них нужен BinaryTree.
+// Писатели одного шарда сериализуются его мьютексом, писатели разных шардов не мешают друг другу.
+// Читатели не берут блокировок: спуск идёт по атомарным ссылкам и проверяется счётчиком версий шарда
+// (seqlock). Счётчик меняется только на время вращений и переноса узла при удалении, поэтому обычная
+// вставка листа не заставляет читателей повторять спуск. Удалённые узлы освобождаются через EpochDomain
+template <typename Key, typename Compare = std::less<Key>, typename Hash = std::hash<Key>>
+class ConcurrentTree {
+public:
+    // Конструктор: число шардов округляется вверх до степени двойки
+    explicit ConcurrentTree(std::size_t shardCount = 64, const Compare& comp = Compare(), const Hash& hash = Hash())
+        : comp(comp), hash(hash) {
+        shardBits = 0;
+        while ((std::size_t(1) << shardBits) < shardCount) {
+            shardBits++;
+        }
+        shards.reset(new Shard[std::size_t(1) << shardBits]);
+    }
+
+    // Деструктор: к этому моменту других потоков, работающих с деревом, быть не должно
+    ~ConcurrentTree() {
+        for (std::size_t i = 0; i < (std::size_t(1) << shardBits); i++) {
+            Shard& shard = shards[i];
+            std::vector<Node*> stack;
+            if (shard.root.load(std::memory_order_relaxed) != nullptr) {
+                stack.push_back(shard.root.load(std::memory_order_relaxed));
+            }
+            while (!stack.empty()) {
+                Node* node = stack.back();
+                stack.pop_back();
+                if (left(node) != nullptr) {
+                    stack.push_back(left(node));
+                }
+                if (right(node) != nullptr) {
+                    stack.push_back(right(node));
+                }
+                shard.pool.destroy(node);
+            }
+            for (const Retired& retired : shard.retired) {
+                shard.pool.destroy(retired.node);
+            }
+        }
+    }
+
+    ConcurrentTree(const ConcurrentTree&) = delete;
+    ConcurrentTree& operator=(const ConcurrentTree&) = delete;
+
+    // Функция для проверки наличия ключа, не берёт блокировок
+    bool contains(const Key& key) const {
+        const Shard& shard = shardFor(key);
+        EpochDomain::Guard guard;
+        return validated(shard, [&] { return find(shard, key); }) != 0;
+    }
+
+    // Функция для поиска наименьшего ключа, возвращает false, если дерево пустое. Не берёт блокировок
+    bool findMin(Key& result) const {
+        return nearest(nullptr, true, result);
+    }
+
+    // Функция для поиска наибольшего ключа, возвращает false, если дерево пустое
+    bool findMax(Key& result) const {
+        return nearest(nullptr, false, result);
+    }
+
+    // Функция для поиска наибольшего ключа, меньшего key (предшественника), возвращает false, если его нет
+    bool predecessor(const Key& key, Key& result) const {
+        return nearest(&key, false, result);
+    }
+
+    // Функция для поиска наименьшего ключа, большего key (преемника), возвращает false, если его нет
+    bool successor(const Key& key, Key& result) const {
+        return nearest(&key, true, result);
+    }
+
+    // Функция для обхода ключей из полуинтервала [from, to) в порядке возрастания: visit(key)
+    template <typename Visitor>
+    void rangeQuery(const Key& from, const Key& to, Visitor visit) const {
+        ordered(&from, &to, visit);
+    }
+
+    // Функция для обхода всех ключей в порядке возрастания: visit(key)
+    template <typename Visitor>
+    void inOrderTraversal(Visitor visit) const {
+        ordered(nullptr, nullptr, visit);
+    }
+
+    // Функция для вставки ключа, возвращает false, если ключ уже есть
+    bool insert(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.writer);
+
+        Link* path[MaxDepth];  // Путь поиска: ссылки на узлы от корня вниз
+        int depth = 0;
+        Link* link = &shard.root;
+        for (Node* node = link->load(std::memory_order_relaxed); node != nullptr; node = link->load(std::memory_order_relaxed)) {
+            path[depth++] = link;
+            if (comp(key, node->key)) {
+                link = &node->left;
+            }
+            else if (comp(node->key, key)) {
+                link = &node->right;
+            }
+            else {
+                return false;
+            }
+        }
+        link->store(shard.pool.create(key), std::memory_order_release);  // Публикуем полностью созданный узел
+        shard.size.fetch_add(1, std::memory_order_relaxed);
+
+        bool writing = false;
+        retrace(shard, path, depth, writing);
+        if (writing) {
+            endWrite(shard);
+        }
+        return true;
+    }
+
+    // Функция для удаления ключа, возвращает false, если ключа нет
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.writer);
+
+        Link* path[MaxDepth];
+        int depth = 0;
+        Link* link = &shard.root;
+        Node* node = link->load(std::memory_order_relaxed);
+        while (node != nullptr && (comp(key, node->key) || comp(node->key, key))) {
+            path[depth++] = link;
+            link = comp(key, node->key) ? &node->left : &node->right;
+            node = link->load(std::memory_order_relaxed);
+        }
+        if (node == nullptr) {
+            return false;
+        }
+
+        bool writing = false;
+        if (left(node) != nullptr && right(node) != nullptr) {
+            // Два потомка: на место узла переносится минимальный узел правого поддерева. Читатель,
+            // ищущий перенесённый ключ, может его не найти, поэтому это делается внутри окна записи
+            beginWrite(shard);
+            writing = true;
+            path[depth++] = link;
+            int belowNode = depth;
+            Link* minLink = &node->right;
+            while (left(minLink->load(std::memory_order_relaxed)) != nullptr) {
+                path[depth++] = minLink;
+                minLink = &minLink->load(std::memory_order_relaxed)->left;
+            }
+
+            Node* minNode = minLink->load(std::memory_order_relaxed);
+            minLink->store(right(minNode), std::memory_order_release);
+            minNode->left.store(left(node), std::memory_order_release);
+            minNode->right.store(right(node), std::memory_order_release);
+            minNode->height = node->height;
+            link->store(minNode, std::memory_order_release);
+            if (depth > belowNode) {
+                path[belowNode] = &minNode->right;  // Ссылка на правое поддерево теперь хранится в minNode
+            }
+        }
+        else {
+            // Читатель, стоящий на удаляемом узле, спустится к его единственному потомку и не ошибётся
+            link->store(left(node) != nullptr ? left(node) : right(node), std::memory_order_release);
+        }
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        retire(shard, node);
+
+        retrace(shard, path, depth, writing);
+        if (writing) {
+            endWrite(shard);
+        }
+        return true;
+    }
+
+    // Число ключей. При одновременных изменениях значение приблизительное
+    std::size_t size() const {
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < (std::size_t(1) << shardBits); i++) {
+            result += shards[i].size.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+private:
+    static const int MaxDepth = 128;  // Больше высоты любого AVL-дерева, помещающегося в память
+    static constexpr std::size_t ReclaimBatch = 64;  // Наименьшее число отцепленных узлов, после которого пробуем их освободить
+    static const int OptimisticScans = 4;  // Попыток обойти шард без блокировки, после них обход идёт под мьютексом шарда
+    static const int ScanCheckEvery = 64;  // Через сколько шагов обхода проверяется версия шарда
+
+    struct Node {
+        Key key;  // Ключ не меняется, пока узел в дереве, поэтому читается без синхронизации
+        std::atomic<Node*> left;
+        std::atomic<Node*> right;
+        int height;  // Высоту читает и пишет только писатель шарда
+
+        explicit Node(const Key& key) : key(key), left(nullptr), right(nullptr), height(1) {}
+    };
+
+    // Ссылка на узел. Писатель сохраняет ссылки с освобождением, поэтому читатель, получивший узел
+    // по любой ссылке (в том числе перевешенной вращением), видит его полностью созданным
+    typedef std::atomic<Node*> Link;
+
+    // Узел, отцепленный в эпоху epoch
+    struct Retired {
+        Node* node;
+        std::uint64_t epoch;
+    };
+
+    struct alignas(64) Shard {
+        std::atomic<unsigned> version;  // Нечётное значение — шард перестраивается
+        Link root;
+        std::atomic<std::size_t> size;
+        std::mutex writer;  // Сериализует писателей шарда
+        NodePool<Node, std::allocator<Node>> pool;  // Используется только под мьютексом
+        std::vector<Retired> retired;
+        std::size_t reclaimAt;  // Размер списка отцепленных узлов, при котором пробуем их освободить
+
+        Shard() : version(0), root(nullptr), size(0), reclaimAt(ReclaimBatch) {}
+    };
+
+    Compare comp;
+    Hash hash;
+    int shardBits;
+    std::unique_ptr<Shard[]> shards;
+
+    // Шард выбирается по старшим битам перемешанного хеша: у std::hash<int> хеш равен самому ключу
+    Shard& shardFor(const Key& key) const {
+        if (shardBits == 0) {
+            return shards[0];
+        }
+        std::uint64_t mixed = static_cast<std::uint64_t>(hash(key)) * 0x9E3779B97F4A7C15ull;
+        return shards[mixed >> (64 - shardBits)];
+    }
+
+    static Node* left(const Node* node) {
+        return node->left.load(std::memory_order_relaxed);
+    }
+
+    static Node* right(const Node* node) {
+        return node->right.load(std::memory_order_relaxed);
+    }
+
+    // Функция для спуска читателя: 1 — ключ найден, 0 — нет, -1 — спуск слишком длинный
+    // (во время вращения ссылки могли временно образовать цикл), результат всё равно отбросит проверка версии
+    int find(const Shard& shard, const Key& key) const {
+        Node* node = shard.root.load(std::memory_order_acquire);
+        for (int depth = 0; node != nullptr; depth++) {
+            if (depth == MaxDepth) {
+                return -1;
+            }
+            if (comp(key, node->key)) {
+                node = node->left.load(std::memory_order_acquire);
+            }
+            else if (comp(node->key, key)) {
+                node = node->right.load(std::memory_order_acquire);
+            }
+            else {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    // Функция для спуска читателя с проверкой версии шарда: read повторяется, пока спуск не пройдёт целиком
+    // без перестройки шарда. read возвращает -1, если спуск нужно повторить в любом случае
+    template <typename Read>
+    static int validated(const Shard& shard, Read read) {
+        while (true) {
+            unsigned version = shard.version.load(std::memory_order_acquire);
+            if ((version & 1) == 0) {
+                int found = read();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (found >= 0 && shard.version.load(std::memory_order_relaxed) == version) {
+                    return found;  // За время спуска форма шарда не менялась
+                }
+            }
+            std::this_thread::yield();  // Писатель перестраивает шард, повторяем спуск
+        }
+    }
+
+    // Функция для спуска к ближайшему ключу шарда: при greater — к наименьшему ключу, большему *key, иначе —
+    // к наибольшему ключу, меньшему *key. Без key — к наименьшему или наибольшему ключу шарда.
+    // Результат как у find: 1 — ключ найден и записан в result, 0 — такого ключа нет, -1 — спуск слишком длинный
+    int nearestIn(const Shard& shard, const Key* key, bool greater, Key& result) const {
+        Node* node = shard.root.load(std::memory_order_acquire);
+        int found = 0;
+        for (int depth = 0; node != nullptr; depth++) {
+            if (depth == MaxDepth) {
+                return -1;
+            }
+            bool fits = key == nullptr || (greater ? comp(*key, node->key) : comp(node->key, *key));
+            if (fits) {
+                result = node->key;  // Подходящий ключ, но ближе к key могут быть ключи в поддереве со стороны key
+                found = 1;
+            }
+            node = (fits == greater ? node->left : node->right).load(std::memory_order_acquire);
+        }
+        return found;
+    }
+
+    // Функция для выбора ближайшего ключа среди ответов всех шардов
+    bool nearest(const Key* key, bool greater, Key& result) const {
+        EpochDomain::Guard guard;
+        bool found = false;
+        for (std::size_t i = 0; i < (std::size_t(1) << shardBits); i++) {
+            Key candidate = Key();
+            if (validated(shards[i], [&] { return nearestIn(shards[i], key, greater, candidate); }) == 0) {
+                continue;
+            }
+            if (!found || (greater ? comp(candidate, result) : comp(result, candidate))) {
+                result = candidate;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // Функция для обхода ключей шарда из [*from, *to) по возрастанию с дописыванием в keys (без границы — до
+    // края шарда). С version обход останавливается с false, как только версия шарда изменилась: вращение могло
+    // ненадолго замкнуть ссылки в цикл, и обход без проверки мог бы не закончиться
+    bool scan(const Shard& shard, const Key* from, const Key* to, std::vector<Key>& keys, const unsigned* version) const {
+        std::vector<Node*> stack;  // Предки с ключами не меньше from, ещё не посещённые
+        Node* node = shard.root.load(std::memory_order_acquire);
+        for (int steps = 1; node != nullptr || !stack.empty(); steps++) {
+            if (version != nullptr && steps % ScanCheckEvery == 0 && shard.version.load(std::memory_order_acquire) != *version) {
+                return false;
+            }
+            if (node != nullptr) {
+                if (from != nullptr && comp(node->key, *from)) {
+                    node = node->right.load(std::memory_order_acquire);  // Узел и его левое поддерево левее диапазона
+                }
+                else {
+                    if (stack.size() == MaxDepth) {
+                        return false;
+                    }
+                    stack.push_back(node);
+                    node = node->left.load(std::memory_order_acquire);
+                }
+                continue;
+            }
+            node = stack.back();
+            stack.pop_back();
+            if (to != nullptr && !comp(node->key, *to)) {
+                break;  // Этот и все следующие ключи шарда не меньше to
+            }
+            keys.push_back(node->key);
+            node = node->right.load(std::memory_order_acquire);
+        }
+        return true;
+    }
+
+    // Функция для сбора ключей шарда. Сначала обход идёт без блокировки и проверяется версией шарда;
+    // если писатели раз за разом перестраивают шард, обход повторяется под мьютексом шарда
+    void collect(Shard& shard, const Key* from, const Key* to, std::vector<Key>& keys) const {
+        std::size_t mark = keys.size();
+        for (int attempt = 0; attempt < OptimisticScans; attempt++) {
+            unsigned version = shard.version.load(std::memory_order_acquire);
+            if ((version & 1) == 0) {
+                bool complete = scan(shard, from, to, keys, &version);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (complete && shard.version.load(std::memory_order_relaxed) == version) {
+                    return;
+                }
+            }
+            keys.erase(keys.begin() + mark, keys.end());
+            std::this_thread::yield();
+        }
+        std::lock_guard<std::mutex> lock(shard.writer);
+        scan(shard, from, to, keys, nullptr);
+    }
+
+    // Функция для упорядоченного обхода: ключи каждого шарда уже отсортированы, отрезки шардов сливаются попарно
+    template <typename Visitor>
+    void ordered(const Key* from, const Key* to, Visitor visit) const {
+        std::vector<Key> keys;
+        std::vector<std::size_t> bounds(1, 0);  // Границы отрезков шардов в keys
+        {
+            EpochDomain::Guard guard;
+            for (std::size_t i = 0; i < (std::size_t(1) << shardBits); i++) {
+                collect(shards[i], from, to, keys);
+                bounds.push_back(keys.size());
+            }
+        }
+        auto lower = [this](const Key& a, const Key& b) { return comp(a, b); };
+        for (std::size_t width = 1; width + 1 < bounds.size(); width *= 2) {
+            for (std::size_t i = 0; i + width + 1 < bounds.size(); i += 2 * width) {
+                std::size_t last = std::min(i + 2 * width, bounds.size() - 1);
+                std::inplace_merge(keys.begin() + bounds[i], keys.begin() + bounds[i + width], keys.begin() + bounds[last], lower);
+            }
+        }
+        for (const Key& key : keys) {
+            visit(key);
+        }
+    }
+
+    // Окно записи: пока версия нечётная, результаты читателей отбрасываются
+    static void beginWrite(Shard& shard) {
+        shard.version.store(shard.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void endWrite(Shard& shard) {
+        shard.version.store(shard.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    static int getHeight(const Node* node) {
+        return node != nullptr ? node->height : 0;
+    }
+
+    static void updateHeight(Node* node) {
+        node->height = 1 + std::max(getHeight(left(node)), getHeight(right(node)));
+    }
+
+    static Node* rightRotate(Node* y) {
+        Node* x = left(y);
+        y->left.store(right(x), std::memory_order_release);
+        x->right.store(y, std::memory_order_release);
+        updateHeight(y);
+        updateHeight(x);
+        return x;
+    }
+
+    static Node* leftRotate(Node* x) {
+        Node* y = right(x);
+        x->right.store(left(y), std::memory_order_release);
+        y->left.store(x, std::memory_order_release);
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    // Функция для балансировки пути снизу вверх, как BinaryTree::retrace.
+    // Окно записи открывается перед первым вращением, writing сообщает, открыто ли оно
+    void retrace(Shard& shard, Link** path, int depth, bool& writing) {
+        while (depth > 0) {
+            Link* link = path[--depth];
+            Node* node = link->load(std::memory_order_relaxed);
+            int oldHeight = node->height;
+            updateHeight(node);
+
+            int balance = getHeight(left(node)) - getHeight(right(node));
+            if (balance > 1 || balance < -1) {
+                if (!writing) {
+                    beginWrite(shard);
+                    writing = true;
+                }
+                if (balance > 1) {
+                    if (getHeight(right(left(node))) > getHeight(left(left(node)))) {
+                        node->left.store(leftRotate(left(node)), std::memory_order_release);
+                    }
+                    node = rightRotate(node);
+                }
+                else {
+                    if (getHeight(left(right(node))) > getHeight(right(right(node)))) {
+                        node->right.store(rightRotate(right(node)), std::memory_order_release);
+                    }
+                    node = leftRotate(node);
+                }
+                link->store(node, std::memory_order_release);
+            }
+            if (node->height == oldHeight) {
+                break;  // Выше по пути высоты и балансы уже не меняются
+            }
+        }
+    }
+
+    // Функция для отложенного освобождения отцепленного узла: узлы копятся в шарде
+    // и возвращаются в пул, когда эпоха ушла на два шага вперёд
+    void retire(Shard& shard, Node* node) {
+        EpochDomain& domain = EpochDomain::instance();
+        // Отцепление должно стать видимым до чтения эпохи. Иначе запись может задержаться в буфере процессора,
+        // читатель, объявивший уже следующую эпоху, дойдёт до узла по старой ссылке, а узел, помеченный
+        // прошлой эпохой, освободится, пока этот читатель ещё на нём. Пара к барьеру в конструкторе Guard
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        shard.retired.push_back({ node, domain.current() });
+        if (shard.retired.size() < shard.reclaimAt) {
+            return;
+        }
+        std::uint64_t epoch = domain.tryAdvance();
+        std::size_t kept = 0;
+        for (const Retired& retired : shard.retired) {
+            if (retired.epoch + 2 <= epoch) {
+                shard.pool.destroy(retired.node);
+            }
+            else {
+                shard.retired[kept++] = retired;
+            }
+        }
+        shard.retired.resize(kept);
+        shard.reclaimAt = std::max(ReclaimBatch, 2 * kept);  // Если читатели держат эпоху, следующая попытка — после удвоения списка
+    }
+};
+
+#endif // CONCURRENTTREE_H
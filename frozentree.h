@@ -0,0 +1,236 @@
+#ifndef FROZENTREE_H
+#define FROZENTREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+// Неизменяемый снимок множества ключей для быстрого поиска.
+// Ключи лежат в массиве в порядке Эйтцингера (обход в ширину неявного сбалансированного дерева):
+// потомки элемента k находятся в 2k и 2k + 1, поэтому спуск не разыменовывает указатели,
+// выбор направления делается без ветвления, а следующие уровни можно заранее подгрузить в кэш.
+// Изменения после построения копятся в небольших отсортированных буферах и сливаются
+// со снимком, когда буферы становятся слишком большими
+template <typename Key, typename Compare = std::less<Key>>
+class FrozenTree {
+public:
+    explicit FrozenTree(const Compare& comp = Compare()) : comp(comp) {
+        layout.resize(1);  // Нулевой элемент не используется, корень имеет индекс 1
+    }
+
+    // Функция для построения снимка из упорядоченной последовательности различных ключей
+    template <typename Iterator>
+    void build(Iterator first, Iterator last) {
+        std::vector<Key> sorted(first, last);
+        rebuild(sorted);
+    }
+
+    // Число ключей в снимке с учётом накопленных изменений
+    std::size_t size() const {
+        return layout.size() - 1 + added.size() - removed.size();
+    }
+
+    // Функция для проверки наличия ключа
+    bool contains(const Key& key) const {
+        std::size_t k = search(key);
+        if (k != 0 && !comp(key, layout[k])) {
+            return !inBuffer(removed, key);  // Ключ есть в основном массиве, если его не удаляли
+        }
+        return inBuffer(added, key);
+    }
+
+    // Функция для поиска наименьшего ключа, не меньшего key. Возвращает nullptr, если такого нет.
+    // Указатель действителен до следующего изменения снимка
+    const Key* lowerBound(const Key& key) const {
+        return boundary(search(key), std::lower_bound(added.begin(), added.end(), key, comp));
+    }
+
+    // Функция для поиска наименьшего ключа, большего key
+    const Key* upperBound(const Key& key) const {
+        return boundary(searchUpper(key), std::upper_bound(added.begin(), added.end(), key, comp));
+    }
+
+    // Функция для учёта вставки ключа в живое дерево
+    void insert(const Key& key) {
+        auto removedIt = std::lower_bound(removed.begin(), removed.end(), key, comp);
+        if (removedIt != removed.end() && !comp(key, *removedIt)) {
+            removed.erase(removedIt);  // Ключ был удалён после построения и вернулся
+            return;
+        }
+        if (contains(key)) {
+            return;
+        }
+        added.insert(std::lower_bound(added.begin(), added.end(), key, comp), key);
+        mergeIfNeeded();
+    }
+
+    // Функция для учёта удаления ключа из живого дерева
+    void erase(const Key& key) {
+        auto addedIt = std::lower_bound(added.begin(), added.end(), key, comp);
+        if (addedIt != added.end() && !comp(key, *addedIt)) {
+            added.erase(addedIt);  // Ключ был добавлен после построения
+            return;
+        }
+        std::size_t k = search(key);
+        if (k == 0 || comp(key, layout[k]) || inBuffer(removed, key)) {
+            return;  // Ключа нет в снимке
+        }
+        removed.insert(std::lower_bound(removed.begin(), removed.end(), key, comp), key);
+        mergeIfNeeded();
+    }
+
+private:
+    Compare comp;
+    std::vector<Key> layout;  // Ключи в порядке Эйтцингера, индексы с 1
+    std::vector<Key> added;  // Отсортированные ключи, добавленные после построения
+    std::vector<Key> removed;  // Отсортированные ключи основного массива, удалённые после построения
+
+    // Число ключей в одной строке кэша: за один запрос подгружаются потомки на log2(KeysPerLine) уровней ниже
+    static const std::size_t KeysPerLine = sizeof(Key) < 64 ? 64 / sizeof(Key) : 1;
+
+    std::size_t count() const {
+        return layout.size() - 1;
+    }
+
+    // Функция для спуска по массиву: индекс наименьшего ключа, не меньшего key, или 0
+    std::size_t search(const Key& key) const {
+        const Key* base = layout.data();
+        std::size_t n = count();
+        std::size_t k = 1;
+        while (k <= n) {
+            prefetch(base, k * KeysPerLine);
+            k = 2 * k + comp(base[k], key);  // Вправо, если текущий ключ меньше искомого
+        }
+        return k >> (trailingOnes(k) + 1);  // Отменяем повороты вправо и последний поворот влево
+    }
+
+    // Функция для спуска по массиву: индекс наименьшего ключа, большего key, или 0
+    std::size_t searchUpper(const Key& key) const {
+        const Key* base = layout.data();
+        std::size_t n = count();
+        std::size_t k = 1;
+        while (k <= n) {
+            prefetch(base, k * KeysPerLine);
+            k = 2 * k + !comp(key, base[k]);  // Вправо, если текущий ключ не больше искомого
+        }
+        return k >> (trailingOnes(k) + 1);
+    }
+
+    // Функция для выбора меньшей из двух границ: в основном массиве (пропуская удалённые ключи) и в буфере добавленных
+    const Key* boundary(std::size_t k, typename std::vector<Key>::const_iterator addedIt) const {
+        while (k != 0 && inBuffer(removed, layout[k])) {
+            k = next(k);
+        }
+        const Key* fromLayout = k != 0 ? &layout[k] : nullptr;
+        const Key* fromAdded = addedIt != added.end() ? &*addedIt : nullptr;
+        if (fromLayout == nullptr) {
+            return fromAdded;
+        }
+        if (fromAdded == nullptr) {
+            return fromLayout;
+        }
+        return comp(*fromAdded, *fromLayout) ? fromAdded : fromLayout;
+    }
+
+    // Функция для перехода к следующему по порядку элементу неявного дерева
+    std::size_t next(std::size_t k) const {
+        std::size_t n = count();
+        if (2 * k + 1 <= n) {
+            k = 2 * k + 1;  // Наименьший ключ правого поддерева
+            while (2 * k <= n) {
+                k = 2 * k;
+            }
+            return k;
+        }
+        return k >> (trailingOnes(k) + 1);  // Поднимаемся, пока приходим из правого поддерева; 0 — конец
+    }
+
+    bool inBuffer(const std::vector<Key>& buffer, const Key& key) const {
+        return std::binary_search(buffer.begin(), buffer.end(), key, comp);
+    }
+
+    // Буферы сливаются со снимком, когда в них больше 64 + 4·sqrt(n) ключей: и вставка в буфер,
+    // и перестройка за O(n), разделённая на число накопленных изменений, стоят O(sqrt(n)) на изменение
+    void mergeIfNeeded() {
+        std::size_t limit = 64;
+        while (limit * limit < 16 * count()) {
+            limit *= 2;  // Степень двойки не меньше 4·sqrt(n)
+        }
+        if (added.size() + removed.size() <= 64 + limit) {
+            return;
+        }
+        std::vector<Key> sorted;
+        sorted.reserve(size());
+        auto addedIt = added.begin();
+        auto removedIt = removed.begin();
+        std::size_t n = count();
+        std::size_t k = 1;
+        while (n != 0 && 2 * k <= n) {
+            k = 2 * k;  // Наименьший ключ снимка
+        }
+        for (; n != 0 && k != 0; k = next(k)) {
+            const Key& key = layout[k];
+            while (addedIt != added.end() && comp(*addedIt, key)) {
+                sorted.push_back(*addedIt++);
+            }
+            if (removedIt != removed.end() && !comp(key, *removedIt)) {
+                ++removedIt;  // Ключ удалён после построения
+                continue;
+            }
+            sorted.push_back(key);
+        }
+        sorted.insert(sorted.end(), addedIt, added.end());
+        rebuild(sorted);
+    }
+
+    // Функция для раскладки отсортированных ключей в порядке Эйтцингера:
+    // элементы неявного дерева перебираются в симметричном порядке и получают ключи по очереди
+    void rebuild(const std::vector<Key>& sorted) {
+        std::vector<Key> result(sorted.size() + 1, sorted.empty() ? Key() : sorted.front());
+        layout.swap(result);
+        added.clear();
+        removed.clear();
+
+        std::size_t n = count();
+        if (n == 0) {
+            return;
+        }
+        std::size_t k = 1;
+        while (2 * k <= n) {
+            k = 2 * k;
+        }
+        for (std::size_t i = 0; i < n; i++, k = next(k)) {
+            layout[k] = sorted[i];
+        }
+    }
+
+    // Число единичных младших битов
+    static int trailingOnes(std::size_t k) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(~static_cast<unsigned long long>(k));
+#else
+        int ones = 0;
+        while (k & 1) {
+            k >>= 1;
+            ones++;
+        }
+        return ones;
+#endif
+    }
+
+    // Подсказка процессору заранее подгрузить строку кэша. Адрес может выходить за конец массива:
+    // предвыборка не обращается к памяти по-настоящему и не вызывает ошибок
+    static void prefetch(const Key* base, std::size_t index) {
+#if defined(__GNUC__)
+        __builtin_prefetch(reinterpret_cast<const char*>(reinterpret_cast<std::uintptr_t>(base) + index * sizeof(Key)));
+#else
+        (void)base;
+        (void)index;
+#endif
+    }
+};
+
+#endif // FROZENTREE_H
@@ -1,233 +1,174 @@
 ﻿#include <iostream>
 #include <string>
-#include <queue>
-#include <algorithm>
+#include <string_view>
+#include <vector>
 
-using namespace std;
-
-// Определение класса узла дерева
-class Node {
-public:
-    int key; // Ключ узла
-    Node* left; // Указатель на левого потомка
-    Node* right; // Указатель на правого потомка
-    int height; // Высота узла в дереве
-
-    // Конструктор узла
-    Node(int key) {
-        this->key = key;
-        this->left = nullptr;
-        this->right = nullptr;
-        this->height = 1; // При создании узла, его высота равна 1
-    }
-};
+#include "binarytree.h"
+#include "commandreader.h"
+#include "treeio.h"
 
-// Определение класса бинарного дерева
-class BinaryTree {
-public:
-    Node* root;  // Указатель на корень дерева
-
-    // Конструктор бинарного дерева
-    BinaryTree() {
-        root = nullptr;  // При создании дерева корень равен nullptr
-    }
+using namespace std;
 
-    // Функция для вставки узла в дерево
-    Node* insert(Node* root, int key) {
-        if (root == nullptr) {
-            return new Node(key);  // Создание нового узла, если текущий узел пустой
-        }
-        if (key < root->key) {
-            root->left = insert(root->left, key);  // Рекурсивная вставка в левое поддерево
-        }
-        else if (key > root->key) {
-            root->right = insert(root->right, key);  // Рекурсивная вставка в правое поддерево
+typedef BinaryTree<int> IntTree;  // Дерево терминальной программы: множество целых ключей
+
+// Пакетный режим: команды по одной в строке, ответы в стандартный вывод, ошибки в стандартный поток ошибок.
+// Команды: insert k..., delete k..., search k, min, max, range от до, select k, rank k, size,
+// balance, autobalance on|off, print [pre|in|post], tree, save файл, load файл.
+// Возвращает число строк с ошибками
+size_t runBatch(IntTree& bst, CommandReader& reader, BufferedWriter& out) {
+    vector<string_view> tokens;
+    vector<int> keys;
+    size_t errors = 0;
+    auto fail = [&](const char* message) {
+        out.flush();  // Ошибка должна оказаться после ответов предыдущих команд
+        cerr << "Строка " << reader.line() << ": " << message << endl;
+        errors++;
+    };
+    // Разбор аргументов-ключей начиная с first; при ошибке строка пропускается целиком
+    auto parseKeys = [&](size_t first, size_t required) {
+        keys.clear();
+        for (size_t i = first; i < tokens.size(); i++) {
+            int key;
+            if (!parseToken(tokens[i], key)) {
+                fail("ожидалось целое число");
+                return false;
+            }
+            keys.push_back(key);
         }
-        return root;
-    }
-
-    // Функция для поиска минимального узла в дереве
-    Node* findMin(Node* node) {
-        while (node->left != nullptr) {
-            node = node->left;  // Проход по левым узлам для нахождения минимального узла
+        if (required != 0 && keys.size() != required) {
+            fail("неверное число аргументов");
+            return false;
         }
-        return node;
-    }
-
-    // Функция для удаления узла из дерева
-    Node* deleteNode(Node* root, int value) {
-        if (root == nullptr) {
-            return root;  // Если дерево пустое, возвращаем nullptr
+        return true;
+    };
+
+    while (reader.next(tokens)) {
+        string_view command = tokens[0];
+        if (command == "insert" || command == "i") {
+            if (parseKeys(1, 0)) {
+                if (keys.size() == 1) {
+                    bst.root = bst.insert(bst.root, keys[0]);
+                }
+                else {
+                    bst.root = bst.insertBatch(bst.root, keys.begin(), keys.end());
+                }
+            }
         }
-
-        if (value < root->key) {
-            root->left = deleteNode(root->left, value);  // Рекурсивное удаление из левого поддерева
+        else if (command == "delete" || command == "d") {
+            if (parseKeys(1, 0)) {
+                for (int key : keys) {
+                    bst.root = bst.deleteNode(bst.root, key);
+                }
+            }
         }
-        else if (value > root->key) {
-            root->right = deleteNode(root->right, value);  // Рекурсивное удаление из правого поддерева
+        else if (command == "search" || command == "s") {
+            if (parseKeys(1, 1)) {
+                out << (bst.search(bst.root, keys[0]) != nullptr ? "found\n" : "not found\n");
+            }
         }
-        else {
-            if (root->left == nullptr) {
-                Node* temp = root->right;
-                delete root;
-                return temp;  // Узел без левого потомка
+        else if (command == "min" || command == "max") {
+            IntTree::Node* result = command == "min" ? bst.findMin(bst.root) : bst.findMax(bst.root);
+            if (result != nullptr) {
+                out << result->key << '\n';
             }
-            else if (root->right == nullptr) {
-                Node* temp = root->left;
-                delete root;
-                return temp;  // Узел без правого потомка
+            else {
+                out << "empty\n";
             }
-            Node* temp = findMin(root->right);
-            root->key = temp->key;
-            root->right = deleteNode(root->right, temp->key);  // Замена удаляемого узла минимальным узлом из правого поддерева
         }
-        return root;
-    }
-
-    // Функция для поиска узла с заданным значением в дереве
-    Node* search(Node* root, int value) {
-        if (root == nullptr || root->key == value) {
-            return root;  // Возвращаем узел, если он равен искомому значению или если дерево пустое
+        else if (command == "range") {
+            if (parseKeys(1, 2)) {
+                bst.rangeQuery(bst.root, keys[0], keys[1], [&out](IntTree::Node* node) {
+                    out << node->key;
+                    out.put(' ');
+                });
+                out.put('\n');
+            }
         }
-
-        if (value < root->key) {
-            return search(root->left, value);  // Рекурсивный поиск в левом поддереве, если значение меньше ключа текущего узла
+        else if (command == "select") {
+            if (parseKeys(1, 1)) {
+                IntTree::Node* result = keys[0] > 0 ? bst.select(bst.root, keys[0] - 1) : nullptr;  // k начиная с 1, как в меню
+                if (result != nullptr) {
+                    out << result->key << '\n';
+                }
+                else {
+                    out << "none\n";
+                }
+            }
         }
-        else {
-            return search(root->right, value);  // Рекурсивный поиск в правом поддереве, если значение больше ключа текущего узла
+        else if (command == "rank") {
+            if (parseKeys(1, 1)) {
+                out << bst.rank(bst.root, keys[0]) << '\n';
+            }
         }
-    }
-
-    // Функция для получения высоты узла в дереве
-    int getHeight(Node* node) {
-        if (node == nullptr) {
-            return 0;  // Возвращаем 0, если узел пустой
+        else if (command == "size") {
+            out << bst.getSize(bst.root) << '\n';
         }
-        return node->height;
-    }
-
-    // Функция для обновления высоты узла на основе высот его потомков
-    void updateHeight(Node* node) {
-        if (node == nullptr) {
-            return;  // Ничего не делаем, если узел пустой
+        else if (command == "balance") {
+            bst.root = bst.rebuildBalanced(bst.root);
         }
-        node->height = 1 + max(getHeight(node->left), getHeight(node->right));  // Обновляем высоту узла
-    }
-
-    // Функция для преобразования дерева в AVL-дерево (балансировка)
-    Node* transformToAVL(Node* root) {
-        if (root == nullptr) {
-            return root;  // Возвращаем nullptr, если дерево пустое
+        else if (command == "autobalance" && tokens.size() == 2 && (tokens[1] == "on" || tokens[1] == "off")) {
+            bst.autoBalance = tokens[1] == "on";
+            if (bst.autoBalance) {
+                bst.root = bst.rebuildBalanced(bst.root);
+            }
         }
-
-        root->left = transformToAVL(root->left);  // Рекурсивное преобразование левого поддерева
-        root->right = transformToAVL(root->right);  // Рекурсивное преобразование правого поддерева
-
-        updateHeight(root);  // Обновляем высоту текущего узла
-
-        int balance = getHeight(root->left) - getHeight(root->right);  // Вычисляем баланс текущего узла
-
-        if (balance > 1) {  // Необходимо правое вращение
-            if (getHeight(root->left->right) > getHeight(root->left->left)) {
-                root->left = leftRotate(root->left);  // Производим левое вращение для левого потомка
+        else if (command == "print") {
+            TraversalOrder order = TraversalOrder::InOrder;
+            if (tokens.size() > 1 && tokens[1] == "pre") {
+                order = TraversalOrder::PreOrder;
+            }
+            else if (tokens.size() > 1 && tokens[1] == "post") {
+                order = TraversalOrder::PostOrder;
             }
-            root = rightRotate(root);  // Правое вращение для текущего узла
+            bst.writeKeys(bst.root, out, order);
+            out.put('\n');
+        }
+        else if (command == "tree") {
+            out.flush();  // printVertical печатает через cout
+            bst.printVertical(bst.root);
+            cout.flush();
         }
-        else if (balance < -1) {  // Необходимо левое вращение
-            if (getHeight(root->right->left) > getHeight(root->right->right)) {
-                root->right = rightRotate(root->right);  // Производим правое вращение для правого потомка
+        else if ((command == "save" || command == "load") && tokens.size() == 2) {
+            try {
+                if (command == "save") {
+                    saveTree(bst, string(tokens[1]));
+                }
+                else {
+                    loadTree(bst, string(tokens[1]));
+                }
+            }
+            catch (const exception& error) {
+                fail(error.what());
             }
-            root = leftRotate(root);  // Левое вращение для текущего узла
         }
-
-        return root;  // Возвращаем корень преобразованного дерева
-    }
-
-
-    Node* rightRotate(Node* y) {
-        Node* x = y->left;
-        Node* T2 = x->right;
-
-        x->right = y;  // Поворачиваем узлы
-        y->left = T2;  // Обновляем левое поддерево узла y
-
-        updateHeight(y);  // Обновляем высоту узла y
-        updateHeight(x);  // Обновляем высоту узла x
-
-        return x;  // Возвращаем новый корень поддерева
-    }
-
-    Node* leftRotate(Node* x) {
-        Node* y = x->right;
-        Node* T2 = y->left;
-
-        y->left = x;  // Поворачиваем узлы
-        x->right = T2;  // Обновляем правое поддерево узла x
-
-        updateHeight(x);  // Обновляем высоту узла x
-        updateHeight(y);  // Обновляем высоту узла y
-
-        return y;  // Возвращаем новый корень поддерева
-    }
-
-    // Прямой обход (pre-order traversal)
-    void preOrderTraversal(Node* root) {
-        if (root == nullptr) {
-            return;
-        }
-        std::cout << root->key << " ";  // Печатаем значение узла
-        preOrderTraversal(root->left);  // Рекурсивно обходим левое поддерево
-        preOrderTraversal(root->right);  // Рекурсивно обходим правое поддерево
-    }
-
-    // Симметричный обход (in-order traversal)
-    void inOrderTraversal(Node* root) {
-        if (root == nullptr) {
-            return;
-        }
-        inOrderTraversal(root->left);  // Рекурсивно обходим левое поддерево
-        std::cout << root->key << " ";  // Печатаем значение узла
-        inOrderTraversal(root->right);  // Рекурсивно обходим правое поддерево
-    }
-
-    // Обратный обход (post-order traversal)
-    void postOrderTraversal(Node* root) {
-        if (root == nullptr) {
-            return;
-        }
-        postOrderTraversal(root->left);  // Рекурсивно обходим левое поддерево
-        postOrderTraversal(root->right);  // Рекурсивно обходим правое поддерево
-        std::cout << root->key << " ";  // Печатаем значение узла
-    }
-
-    // Вертикальная печать
-    void printVertical(Node* root, int level = 0, char ch = ' ') {
-        // Рекурсивная функция для печати дерева с использованием символов для указания отношений между узлами
-        if (root->right != nullptr) printVertical(root->right, level + 1, '/'); // Печать правого поддерева
-        for (int i = 0; i < level; i++) {
-            std::cout << "   "; // Отступ для наглядности уровня узла в дереве
-        }
-        std::cout << ch << "-- " << root->key << std::endl; // Вывод узла с символом и ключом
-        if (root->left != nullptr) printVertical(root->left, level + 1, '\\'); // Печать левого поддерева
+        else {
+            fail("неизвестная команда");
+        }
     }
+    return errors;
+}
 
-    // Горизонтальная печать
-    void printHorizontal(const Node* root, const string& symbol = "", bool rootFlag = true, bool last = true) {
-        // Рекурсивная функция для горизонтальной печати дерева с использованием символов для указания отношений между узлами
-        cout << symbol << (rootFlag ? "" : (last ? "+--" : "|--")) << (root ? to_string(root->key) : "") << endl; // Вывод узла с символами для связей
-        if (!root) { return; }
-
-        vector<Node*> v = { root->left, root->right }; // Создание вектора дочерних узлов
-
-        for (size_t i = 0; i < v.size(); i++) {
-            printHorizontal(v[i], symbol + (rootFlag ? "" : (last ? "    " : "|   ")), false, i + 1 >= v.size()); // Рекурсивный вызов для каждого дочернего узла
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        // Пакетный режим: команды из файла или из стандартного ввода, без меню и вызовов system
+        IntTree bst(true);
+        try {
+            BufferedWriter out;
+            if (argc > 2) {
+                CommandReader reader{ string(argv[2]) };
+                return runBatch(bst, reader, out) == 0 ? 0 : 1;
+            }
+            CommandReader reader;
+            return runBatch(bst, reader, out) == 0 ? 0 : 1;
+        }
+        catch (const exception& error) {
+            cerr << error.what() << endl;
+            return 2;
         }
     }
-};
 
-int main() {
     system("chcp 1251 > null");
-    BinaryTree bst;
+    IntTree bst;
 
     while (true) {
         char choice;
@@ -238,6 +179,10 @@ int main() {
         cout << "1. Вставить узел" << endl;
         cout << "2. Удалить узел" << endl;
         cout << "3. Вывести дерево" << endl;
+        cout << "4. Автобалансировка: " << (bst.autoBalance ? "вкл" : "выкл") << endl;
+        cout << "5. Вставить несколько узлов" << endl;
+        cout << "6. Сохранить дерево в файл" << endl;
+        cout << "7. Загрузить дерево из файла" << endl;
         cout << "0. Выход" << endl;
         cout << "----------------------" << endl;
         cout << "Выберите действие: ";
@@ -265,6 +210,50 @@ int main() {
             bst.printVertical(bst.root);
             system("pause");
         }
+        else if (choice == '4') {
+            bst.autoBalance = !bst.autoBalance;
+            if (bst.autoBalance) {
+                bst.root = bst.rebuildBalanced(bst.root);  // Приводим уже построенное дерево к AVL перед включением режима
+            }
+        }
+        else if (choice == '5') {
+            int count;
+            cout << "Введите количество значений: ";
+            cin >> count;
+            vector<int> keys(count > 0 ? count : 0);
+            cout << "Введите значения через пробел: ";
+            for (int& key : keys) {
+                cin >> key;
+            }
+            bst.root = bst.insertBatch(bst.root, keys.begin(), keys.end());  // Вся пачка вставляется за один проход по дереву
+            cout << "Узлы успешно вставлены!" << endl;
+        }
+        else if (choice == '6') {
+            string path;
+            cout << "Введите имя файла: ";
+            cin >> path;
+            try {
+                saveTree(bst, path);
+                cout << "Дерево успешно сохранено!" << endl;
+            }
+            catch (const exception& error) {
+                cout << "Ошибка: " << error.what() << endl;
+            }
+            system("pause");
+        }
+        else if (choice == '7') {
+            string path;
+            cout << "Введите имя файла: ";
+            cin >> path;
+            try {
+                loadTree(bst, path);  // Загруженное дерево всегда сбалансировано
+                cout << "Дерево успешно загружено!" << endl;
+            }
+            catch (const exception& error) {
+                cout << "Ошибка: " << error.what() << endl;
+            }
+            system("pause");
+        }
         system("cls");
     }
 
@@ -278,6 +267,10 @@ int main() {
         cout << "----------------------" << std::endl;
         cout << "1. Найти узел по ключу" << std::endl;
         cout << "2. Найти минимум" << std::endl;
+        cout << "3. Найти максимум" << std::endl;
+        cout << "4. Найти ключи в диапазоне" << std::endl;
+        cout << "5. Найти k-й по величине ключ" << std::endl;
+        cout << "6. Узнать порядковый номер ключа" << std::endl;
         cout << "0. Выход" << std::endl;
         cout << "----------------------" << std::endl;
         cout << "Выберите действие: ";
@@ -291,7 +284,7 @@ int main() {
             int key;
             cout << "Введите ключ: ";
             cin >> key;
-            Node* result = bst.search(bst.root, key);
+            IntTree::Node* result = bst.search(bst.root, key);
             if (result != nullptr) {
                 cout << "Значение найдено в дереве!" << std::endl;
             }
@@ -301,7 +294,7 @@ int main() {
             system("pause");
         }
         else if (choice == '2') {
-            Node* result = bst.findMin(bst.root);
+            IntTree::Node* result = bst.findMin(bst.root);
             if (result != nullptr) {
                 cout << "Минимальное значение в дереве: " << result->key << std::endl;
             }
@@ -310,6 +303,44 @@ int main() {
             }
             system("pause");
         }
+        else if (choice == '3') {
+            IntTree::Node* result = bst.findMax(bst.root);
+            if (result != nullptr) {
+                cout << "Максимальное значение в дереве: " << result->key << std::endl;
+            }
+            else {
+                cout << "Дерево пустое" << std::endl;
+            }
+            system("pause");
+        }
+        else if (choice == '4') {
+            int from, to;
+            cout << "Введите границы диапазона [от, до): ";
+            cin >> from >> to;
+            bst.rangeQuery(bst.root, from, to, [](IntTree::Node* node) { cout << node->key << " "; });
+            cout << std::endl;
+            system("pause");
+        }
+        else if (choice == '5') {
+            int k;
+            cout << "Введите k (начиная с 1): ";
+            cin >> k;
+            IntTree::Node* result = k > 0 ? bst.select(bst.root, k - 1) : nullptr;
+            if (result != nullptr) {
+                cout << k << "-й по величине ключ: " << result->key << std::endl;
+            }
+            else {
+                cout << "В дереве меньше " << k << " ключей" << std::endl;
+            }
+            system("pause");
+        }
+        else if (choice == '6') {
+            int key;
+            cout << "Введите ключ: ";
+            cin >> key;
+            cout << "Ключей меньше " << key << ": " << bst.rank(bst.root, key) << std::endl;
+            system("pause");
+        }
         system("cls");
     }
 
@@ -331,7 +362,7 @@ int main() {
             break;
         }
         else if (choice == '1') {
-            bst.root = bst.transformToAVL(bst.root);
+            bst.root = bst.rebuildBalanced(bst.root);
             cout << "Дерево успешно сбалансировано!" << endl;
             system("pause");
         }
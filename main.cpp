@@ -4,277 +4,584 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QCheckBox>
+#include <QFileDialog>
 #include <QInputDialog>
 #include <QPainter>
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QFontMetrics>
+#include <QStringList>
 #include <QMessageBox>
-
-// Структура узла бинарного дерева
-struct Node {
-    int key;
-    Node* left;
-    Node* right;
-    int height;
-
-    Node(int value) : key(value), left(nullptr), right(nullptr), height(1) {}
-};
+#include <QMetaObject>
+#include <QMouseEvent>
+#include <QPainterPath>
+#include <QPixmap>
+#include <QPolygonF>
+#include <QProgressBar>
+#include <QRegion>
+#include <QTimer>
+#include <QVector>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "treeengine.h"
+#include "treeio.h"
+#include "treelayout.h"
+#include "treereplay.h"
+
+typedef TreeEngine<int> IntEngine;  // Дерево виджета: множество целых ключей в рабочем потоке
+typedef TreeLayout<int> IntLayout;
+typedef TreeReplay<int> IntReplay;
+typedef TreeEventLog<int> IntEventLog;
 
 class BinaryTreeWidget : public QWidget {
 public:
-    BinaryTreeWidget(QWidget* parent = nullptr) : QWidget(parent), root(nullptr) {}
+    // Дерево живёт в рабочем потоке движка. Снимки и ход операций приходят оттуда и передаются
+    // в поток интерфейса очередью событий виджета
+    BinaryTreeWidget(QWidget* parent = nullptr)
+        : QWidget(parent),
+          snapshot(std::make_shared<IntEngine::Snapshot>()),
+          engine(
+              [this](std::shared_ptr<const IntEngine::Snapshot> next) {
+                  QMetaObject::invokeMethod(this, [this, next] { showSnapshot(next); }, Qt::QueuedConnection);
+              },
+              [this](const TreeProgress& progress) {
+                  QMetaObject::invokeMethod(this, [this, progress] {
+                      if (progressHandler) {
+                          progressHandler(progress);
+                      }
+                  }, Qt::QueuedConnection);
+              }) {
+        animationTimer.setInterval(FrameMilliseconds);
+        QObject::connect(&animationTimer, &QTimer::timeout, [this] { animationFrame(); });
+        engine.setRecordEvents(animationEnabled);
+    }
+
+    // Обработчик хода длинных операций, вызывается в потоке интерфейса
+    void setProgressHandler(std::function<void(const TreeProgress&)> handler) {
+        progressHandler = std::move(handler);
+    }
+
+    // Включение режима самобалансировки: вставка и удаление сразу поддерживают AVL-свойство
+    void setAutoBalance(bool enabled) {
+        engine.setAutoBalance(enabled);  // Уже построенное дерево приводится к AVL перед включением режима
+    }
+
+    // Включение анимации: переходы между снимками проигрываются по журналу изменений дерева —
+    // вставки, удаления и вращения видны по шагам, а не скачком к новой форме
+    void setAnimation(bool enabled) {
+        animationEnabled = enabled;
+        engine.setRecordEvents(enabled);
+        if (!enabled && animationTimer.isActive()) {
+            stopAnimation();
+        }
+    }
 
     void insertNode(int key) {
-        root = insert(root, key);
-        update();
+        engine.insert(key);
     }
 
     void deleteNode(int key) {
-        root = deleteNode(root, key);
-        update();
+        engine.remove(key);
     }
 
-    bool searchNode(int key) {
-        return search(root, key);
+    // Поиск: done(найден ли ключ) вызывается в потоке интерфейса, когда дойдёт очередь
+    void searchNode(int key, std::function<void(bool)> done) {
+        engine.search(key, [this, done](bool found) {
+            QMetaObject::invokeMethod(this, [done, found] { done(found); }, Qt::QueuedConnection);
+        });
+    }
+
+    // Отмена всех поставленных операций
+    void cancelOperations() {
+        engine.cancel();
     }
 
     void preOrderTraversal() {
-        preOrder(root);
+        printKeys(TraversalOrder::PreOrder);
     }
 
     void inOrderTraversal() {
-        inOrder(root);
+        printKeys(TraversalOrder::InOrder);
     }
 
     void postOrderTraversal() {
-        postOrder(root);
+        printKeys(TraversalOrder::PostOrder);
     }
 
-    void balanceTree() {
-        root = transformToAVL(root);
-        update();
+    // Печать ключей в qDebug блоками: один вызов qDebug на блок вместо вызова на каждый узел.
+    // Обход идёт в рабочем потоке, qDebug потокобезопасен
+    void printKeys(TraversalOrder order) {
+        engine.traverse(order, [](const char* data, std::size_t size) {
+            qDebug().noquote() << QString::fromLatin1(data, static_cast<int>(size));
+        });
     }
 
-    // Метод отрисовки виджета
-    void paintEvent(QPaintEvent* event) override {
-        Q_UNUSED(event); // Подавляем предупреждение о неиспользуемом параметре события отрисовки
-
-        QPainter painter(this); // Создаем объект QPainter для отрисовки на виджете
-        painter.setRenderHint(QPainter::Antialiasing); // Устанавливаем сглаживание для рисования
-
-        int initialX = width() / 2; // Вычисляем начальное положение X для отрисовки корня дерева по центру виджета
-        int initialY = 50; // Определяем начальное положение Y для отрисовки корня дерева
+    void balanceTree() {
+        engine.balance();
+    }
 
-        drawTree(painter, initialX, initialY, root, 1); // Вызываем функцию для отрисовки всего дерева, начиная с корня
+    // Импорт ключей из файла дерева или текстового файла. Файл читается в рабочем потоке,
+    // ключи вставляются одной пачкой, раскладка и перерисовка — один раз в конце
+    void importFile(const QString& path) {
+        std::string file = path.toStdString();
+        engine.loadKeys([file] {
+            return readKeys<int>(file);
+        });
     }
 
-private:
-    Node* root;
-
-    // Функция для вставки узла в дерево
-    Node* insert(Node* root, int key) {
-        if (root == nullptr) {
-            return new Node(key);  // Создание нового узла, если текущий узел пустой
-        }
-        if (key < root->key) {
-            root->left = insert(root->left, key);  // Рекурсивная вставка в левое поддерево
-        }
-        else if (key > root->key) {
-            root->right = insert(root->right, key);  // Рекурсивная вставка в правое поддерево
-        }
-        return root;
-    }
-
-    // Функция для поиска минимального узла в дереве
-    Node* findMin(Node* node) {
-        while (node->left != nullptr) {
-            node = node->left;  // Проход по левым узлам для нахождения минимального узла
-        }
-        return node;
-    }
-
-    Node* deleteNode(Node* node, int key) {
-        if (node == nullptr) {
-            return nullptr;
-        }
-
-        if (key < node->key) {
-            node->left = deleteNode(node->left, key);
-        } else if (key > node->key) {
-            node->right = deleteNode(node->right, key);
-        } else {
-            if (node->left == nullptr && node->right == nullptr) {
-                delete node;
-                return nullptr;
-            } else if (node->left == nullptr) {
-                Node* temp = node->right;
-                delete node;
-                return temp;
-            } else if (node->right == nullptr) {
-                Node* temp = node->left;
-                delete node;
-                return temp;
-            } else {
-                Node* minNode = findMin(node->right);
-                node->key = minNode->key;
-                node->right = deleteNode(node->right, minNode->key);
+    // Импорт count сгенерированных ключей: случайных неотрицательных или 1, 2, ..., count по возрастанию
+    void generateKeys(int count, bool sorted) {
+        engine.loadKeys([count, sorted] {
+            std::vector<int> keys(static_cast<std::size_t>(count));
+            if (sorted) {
+                for (int i = 0; i < count; i++) {
+                    keys[i] = i + 1;
+                }
             }
-        }
+            else {
+                std::mt19937 random(std::random_device{}());
+                std::uniform_int_distribution<int> distribution(0, INT_MAX);
+                for (int& key : keys) {
+                    key = distribution(random);
+                }
+            }
+            return keys;
+        });
+    }
 
-        return node;
+    // Функция для подгонки масштаба так, чтобы всё дерево поместилось в окно
+    void fitToWindow() {
+        const IntLayout& layout = *snapshot->layout;
+        if (layout.empty()) {
+            return;
+        }
+        double margin = 2 * IntLayout::Radius + 20;
+        zoom = std::min({ width() / (layout.width() + margin), height() / (layout.height() + margin), 1.0 });
+        offset = QPointF(width() / 2.0 - layout.rootX() * zoom, 50);
+        repaintAll();
     }
 
-    // Функция для поиска узла с заданным значением в дереве
-    Node* search(Node* root, int value) {
-        if (root == nullptr || root->key == value) {
-            return root;  // Возвращаем узел, если он равен искомому значению или если дерево пустое
+    // Метод отрисовки виджета: дерево хранится в буфере canvas, и заново рисуются только устаревшие
+    // его области. Остальное копируется из буфера. Во время анимации кадр рисуется прямо на виджете,
+    // а буфер обновляется после её конца
+    void paintEvent(QPaintEvent* event) override {
+        Q_UNUSED(event); // Qt сам ограничивает рисование на виджете областью события
+
+        bool animating = animationTimer.isActive();
+        qreal ratio = devicePixelRatioF();
+        if (canvas.size() != size() * ratio) {
+            canvas = QPixmap(size() * ratio);
+            canvas.setDevicePixelRatio(ratio);
+            canvasDirty = rect();
+        }
+#if defined(BINARYTREE_STATS)
+        QElapsedTimer timer;
+        timer.start();
+#endif
+        if (!canvasDirty.isEmpty() && !animating) {
+            QPainter canvasPainter(&canvas);
+            canvasPainter.setRenderHint(QPainter::Antialiasing); // Устанавливаем сглаживание для рисования
+            for (const QRect& area : canvasDirty) {
+                canvasPainter.setClipRect(area);
+                canvasPainter.fillRect(area, palette().window());
+                drawTree(canvasPainter, area); // Рисуем часть дерева, попавшую в область
+            }
+            canvasDirty = QRegion();
         }
 
-        if (value < root->key) {
-            return search(root->left, value);  // Рекурсивный поиск в левом поддереве, если значение меньше ключа текущего узла
+        QPainter painter(this); // Создаем объект QPainter для отрисовки на виджете
+        if (animating) {
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.fillRect(rect(), palette().window());
+            drawAnimation(painter);
         }
         else {
-            return search(root->right, value);  // Рекурсивный поиск в правом поддереве, если значение больше ключа текущего узла
+            painter.drawPixmap(0, 0, canvas);
         }
+#if defined(BINARYTREE_STATS)
+        paints++;
+        lastPaintMicroseconds = timer.nsecsElapsed() / 1000;
+        drawStats(painter);
+#endif
     }
 
-    // Прямой обход (pre-order traversal)
-    void preOrder(Node* root) {
-        if (root == nullptr) {
-            return;
-        }
-        qDebug() << root->key;  // Печатаем значение узла
-        preOrder(root->left);  // Рекурсивно обходим левое поддерево
-        preOrder(root->right);  // Рекурсивно обходим правое поддерево
+protected:
+    // Колесо мыши масштабирует вид относительно курсора
+    void wheelEvent(QWheelEvent* event) override {
+        double newZoom = std::clamp(zoom * std::pow(1.0015, event->angleDelta().y()), 1e-6, 20.0);
+        QPointF cursor = event->position();
+        offset = cursor - (cursor - offset) * (newZoom / zoom);  // Точка под курсором остаётся на месте
+        zoom = newZoom;
+        repaintAll();
     }
 
-    // Симметричный обход (in-order traversal)
-    void inOrder(Node* root) {
-        if (root == nullptr) {
-            return;
+    // Перетаскивание левой кнопкой сдвигает вид, двойной щелчок вписывает дерево в окно
+    void mousePressEvent(QMouseEvent* event) override {
+        if (event->button() == Qt::LeftButton) {
+            dragging = true;
+            lastMouse = event->localPos();
         }
-        inOrder(root->left);  // Рекурсивно обходим левое поддерево
-        qDebug() << root->key; // Печатаем значение узла
-        inOrder(root->right);  // Рекурсивно обходим правое поддерево
     }
 
-    // Обратный обход (post-order traversal)
-    void postOrder(Node* root) {
-        if (root == nullptr) {
-            return;
+    void mouseMoveEvent(QMouseEvent* event) override {
+        if (dragging) {
+            QPoint delta = (event->localPos() - lastMouse).toPoint();  // Сдвиг на целые пиксели: буфер прокручивается без пересэмплирования
+            if (!delta.isNull()) {
+                lastMouse += delta;
+                offset += delta;
+                scrollCanvas(delta);
+            }
         }
-        postOrder(root->left);  // Рекурсивно обходим левое поддерево
-        postOrder(root->right);  // Рекурсивно обходим правое поддерево
-        qDebug() << root->key;  // Печатаем значение узла
     }
 
-    // Функция для получения высоты узла в дереве
-    int getHeight(Node* node) {
-        if (node == nullptr) {
-            return 0;  // Возвращаем 0, если узел пустой
+    void mouseReleaseEvent(QMouseEvent* event) override {
+        if (event->button() == Qt::LeftButton) {
+            dragging = false;
         }
-        return node->height;
     }
 
-    // Функция для обновления высоты узла на основе высот его потомков
-    void updateHeight(Node* node) {
-        if (node == nullptr) {
-            return;  // Ничего не делаем, если узел пустой
-        }
-        node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));  // Обновляем высоту узла
+    void mouseDoubleClickEvent(QMouseEvent* event) override {
+        Q_UNUSED(event);
+        fitToWindow();
     }
 
-    // Функция для преобразования дерева в AVL-дерево (балансировка)
-    Node* transformToAVL(Node* root) {
-        if (root == nullptr) {
-            return root;  // Возвращаем nullptr, если дерево пустое
+private:
+    std::shared_ptr<const IntEngine::Snapshot> snapshot;  // Последний полученный снимок дерева, по нему идёт отрисовка
+    std::function<void(const TreeProgress&)> progressHandler;
+    QPixmap canvas;  // Нарисованное дерево в экранных координатах
+    QRegion canvasDirty;  // Области canvas, которые нужно нарисовать заново
+    double zoom = 1.0;  // Экранных пикселей на мировую единицу
+    QPointF offset;  // Экранное положение мировой точки (0, 0)
+    bool dragging = false;
+    QPointF lastMouse;
+    IntReplay replay;  // Копия формы дерева, на которой проигрываются изменения
+    std::deque<std::shared_ptr<const IntEventLog>> replayLogs;  // Журналы снимков, ещё не проигранные до конца
+    std::size_t replayEvent = 0;  // Следующее событие первого журнала
+    std::size_t replayPending = 0;  // Непроигранных событий во всех журналах
+    std::uint64_t replayVersion = 0;  // Снимок, с которым совпадёт копия после всех журналов
+    std::size_t stepRemaining = 0;  // Событий текущего шага, ещё не применённых к копии
+    double stepDuration = 0;  // Длительность текущего шага, мс
+    QElapsedTimer stepClock;  // Время от начала движения узлов в текущем шаге
+    QTimer animationTimer;  // Кадры анимации, работает, пока она идёт
+    bool animationEnabled = true;
+    IntEngine engine;  // Последним: при разрушении виджета рабочий поток останавливается первым
+
+    static constexpr double LodPixels = 6;  // Поддерево уже этого числа пикселей рисуется одним треугольником
+    static constexpr int FrameMilliseconds = 16;  // Период кадров анимации
+    static constexpr qint64 FrameBudget = 8;  // Время на применение событий за кадр, мс: остаток кадра — отрисовке и вводу
+    static constexpr double EventDuration = 400;  // Шаг на одно событие, пока событий мало, мс
+    static constexpr double MinStepDuration = 80;  // Самый короткий шаг: при многих событиях шаг применяет их пачку
+    static constexpr double MaxAnimationDuration = 4000;  // Очередь событий проигрывается не дольше, мс
+    static constexpr std::size_t MaxAnimatedNodes = 1 << 18;  // Большие деревья меняются без анимации
+
+    // Функция для перехода к новому снимку: перерисовываются только области, изменившиеся с прошлого
+    // снимка, или всё, если раскладка собрана заново. Первый узел ставится в середину окна
+    void showSnapshot(std::shared_ptr<const IntEngine::Snapshot> next) {
+        bool wasEmpty = snapshot->layout->empty();
+        bool animated = queueAnimation(*next);
+        snapshot = std::move(next);
+        const IntLayout& layout = *snapshot->layout;
+        if (wasEmpty || layout.empty()) {
+            offset = QPointF(width() / 2.0 - layout.rootX() * zoom, 50);
         }
+        if (animated) {
+            return;  // Кадры рисует анимация, буфер перерисуется целиком после неё
+        }
+        if (wasEmpty || layout.empty() || snapshot->rebuilt) {
+            repaintAll();
+            return;
+        }
+        const LayoutChange& change = snapshot->change;
+        QRegion region;
+        for (const LayoutRect& area : change.areas) {
+            region += toScreen(area);
+        }
+        for (const LayoutRect& area : change.subtrees) {
+            // Поддерево пути выглядит иначе только там, где оно свёрнуто в треугольник
+            if ((area.right - area.left - 2 * IntLayout::Radius - 2 * IntLayout::Spacing) * zoom < LodPixels) {
+                region += toScreen(area);
+            }
+        }
+        invalidate(region);
+    }
 
-        root->left = transformToAVL(root->left);  // Рекурсивное преобразование левого поддерева
-        root->right = transformToAVL(root->right);  // Рекурсивное преобразование правого поддерева
-
-        updateHeight(root);  // Обновляем высоту текущего узла
-
-        int balance = getHeight(root->left) - getHeight(root->right);  // Вычисляем баланс текущего узла
+    // Функция для постановки изменений снимка next в очередь анимации. Журнал снимка проигрывается на копии
+    // формы с прошлого снимка. Возвращает false, если переход показывается сразу: анимация выключена,
+    // журнал неполный или пустой, или дерево слишком велико. Такой снимок прерывает идущую анимацию
+    bool queueAnimation(const IntEngine::Snapshot& next) {
+        bool running = animationTimer.isActive();
+        std::uint64_t base = running ? replayVersion : snapshot->version;
+        std::size_t nodes = std::max(snapshot->layout->getNodes().size(), next.layout->getNodes().size());
+        bool replayable = animationEnabled && next.events && next.events->complete && base + 1 == next.version &&
+                          nodes <= MaxAnimatedNodes;
+        if (!replayable || (!running && next.events->events.empty())) {
+            if (running) {
+                stopAnimation();
+            }
+            return false;
+        }
+        if (!running) {
+            replay.reset(*snapshot->layout);
+            stepRemaining = 0;
+            stepDuration = 0;
+            stepClock.start();
+            animationTimer.start();
+        }
+        if (!next.events->events.empty()) {
+            replayLogs.push_back(next.events);
+            replayPending += next.events->events.size();
+        }
+        replayVersion = next.version;
+        return true;
+    }
 
-        if (balance > 1) {  // Необходимо правое вращение
-            if (getHeight(root->left->right) > getHeight(root->left->left)) {
-                root->left = leftRotate(root->left);  // Производим левое вращение для левого потомка
+    // Кадр анимации. В начале шага к копии применяются события шага, но не дольше FrameBudget за кадр:
+    // остаток переносится на следующие кадры, поэтому даже 100 тысяч вращений не задерживают ввод.
+    // Затем кадры шага рисуют узлы на пути от старых положений к новым
+    void animationFrame() {
+        if (stepRemaining == 0 && stepClock.elapsed() >= stepDuration) {
+            if (replayPending == 0) {
+                stopAnimation();
+                return;
             }
-            root = rightRotate(root);  // Правое вращение для текущего узла
+            // Чем больше событий в очереди, тем короче шаги и больше событий в шаге: вся очередь
+            // проигрывается не дольше MaxAnimationDuration, а малые изменения — по событию за шаг
+            stepDuration = std::clamp(MaxAnimationDuration / replayPending, MinStepDuration, EventDuration);
+            stepRemaining = std::min(replayPending,
+                                     static_cast<std::size_t>(std::ceil(replayPending * stepDuration / MaxAnimationDuration)));
+            replay.beginStep();
         }
-        else if (balance < -1) {  // Необходимо левое вращение
-            if (getHeight(root->right->left) > getHeight(root->right->right)) {
-                root->right = rightRotate(root->right);  // Производим правое вращение для правого потомка
+        if (stepRemaining > 0) {
+            QElapsedTimer budget;
+            budget.start();
+            do {
+                for (int i = 0; i < 1024 && stepRemaining > 0; i++) {  // Время проверяется раз в пачку событий
+                    const IntEventLog& log = *replayLogs.front();
+                    if (!replay.apply(log.events[replayEvent])) {
+                        stopAnimation();  // Копия разошлась с деревом: показываем снимок как есть
+                        return;
+                    }
+                    stepRemaining--;
+                    replayPending--;
+                    if (++replayEvent == log.events.size()) {
+                        replayLogs.pop_front();
+                        replayEvent = 0;
+                    }
+                }
+            } while (stepRemaining > 0 && budget.elapsed() < FrameBudget);
+            if (stepRemaining > 0) {
+                return;  // Шаг продолжится в следующем кадре, на экране остаётся прежний кадр
             }
-            root = leftRotate(root);  // Левое вращение для текущего узла
+            replay.place();
+            stepClock.start();
         }
-
-        return root;  // Возвращаем корень преобразованного дерева
+        update();
     }
 
-    Node* rightRotate(Node* y) {
-        Node* x = y->left;
-        Node* T2 = x->right;
-
-        x->right = y;  // Поворачиваем узлы
-        y->left = T2;  // Обновляем левое поддерево узла y
-
-        updateHeight(y);  // Обновляем высоту узла y
-        updateHeight(x);  // Обновляем высоту узла x
-
-        return x;  // Возвращаем новый корень поддерева
+    // Функция для остановки анимации: непроигранные события отбрасываются, виджет показывает последний снимок
+    void stopAnimation() {
+        animationTimer.stop();
+        replayLogs.clear();
+        replayEvent = 0;
+        replayPending = 0;
+        stepRemaining = 0;
+        repaintAll();
     }
 
-    Node* leftRotate(Node* x) {
-        Node* y = x->right;
-        Node* T2 = y->left;
-
-        y->left = x;  // Поворачиваем узлы
-        x->right = T2;  // Обновляем правое поддерево узла x
-
-        updateHeight(x);  // Обновляем высоту узла x
-        updateHeight(y);  // Обновляем высоту узла y
+    void invalidate(const QRegion& region) {
+        canvasDirty += region;
+#if defined(BINARYTREE_STATS)
+        update(region + statsPanel);  // Панель статистики перерисовывается целиком при каждой перерисовке
+#else
+        update(region);
+#endif
+    }
 
-        return y;  // Возвращаем новый корень поддерева
+    void repaintAll() {
+        canvasDirty = rect();
+        update();
     }
 
-    void drawTree(QPainter& painter, int x, int y, Node* node, int level) {
-        if (node == nullptr) {
-            return;  // Если узел пуст, завершаем функцию
+    // Функция для сдвига нарисованного дерева на delta пикселей: буфер прокручивается, заново рисуются
+    // только открывшиеся полосы
+    void scrollCanvas(const QPoint& delta) {
+        qreal ratio = canvas.devicePixelRatio();
+        if (canvas.isNull() || ratio != std::floor(ratio)) {
+            repaintAll();  // При дробном масштабе экрана пиксели буфера не совпадают с целыми сдвигами
+            return;
         }
+        canvas.scroll(delta.x() * static_cast<int>(ratio), delta.y() * static_cast<int>(ratio), canvas.rect());
+        canvasDirty.translate(delta);
+        canvasDirty += QRegion(rect()) - rect().translated(delta);
+        update();  // Окно копирует весь сдвинутый буфер, это дёшево
+    }
 
-        int radius = 20;  // Радиус узла
-        int spacing = 100;  // Расстояние между узлами на одном уровне
-        int levelHeight = 80;  // Высота уровня
-
-        // Рисуем круг для узла
-        painter.setPen(Qt::black);
-        painter.setBrush(Qt::white);
-        painter.drawEllipse(QPointF(x, y), radius, radius);
+    // Функция для перевода мировой области в экранный прямоугольник. Область обрезается по окну
+    // (стороны могут быть бесконечными) и расширяется на пиксель-другой под сглаживание
+    QRect toScreen(const LayoutRect& area) const {
+        double left = std::max(area.left * zoom + offset.x(), -1.0);
+        double top = std::max(area.top * zoom + offset.y(), -1.0);
+        double right = std::min(area.right * zoom + offset.x(), width() + 1.0);
+        double bottom = std::min(area.bottom * zoom + offset.y(), height() + 1.0);
+        if (left > right || top > bottom) {
+            return QRect();
+        }
+        return QRectF(QPointF(left, top), QPointF(right, bottom)).toAlignedRect().adjusted(-2, -2, 2, 2) & rect();
+    }
 
-        // Помещаем текст (ключ узла) в центр круга
+#if defined(BINARYTREE_STATS)
+    long long paints = 0;  // Число перерисовок виджета
+    long long lastPaintMicroseconds = 0;  // Время отрисовки дерева в последней перерисовке
+    QRect statsPanel;  // Место панели статистики на экране
+
+    // Панель статистики в левом верхнем углу поверх дерева, обновляется при каждой перерисовке
+    void drawStats(QPainter& painter) {
+        const TreeStats& stats = snapshot->stats;
+        QStringList lines;
+        lines << QString("Узлов: %1, высота: %2 (минимум %3)").arg(stats.size).arg(stats.height).arg(stats.optimalHeight);
+        lines << QString("Вставки: %1, повторные: %2").arg(stats.inserts).arg(stats.duplicateInserts);
+        lines << QString("Удаления: %1, с двумя потомками: %2, мимо: %3").arg(stats.deletes).arg(stats.twoChildDeletes).arg(stats.missedDeletes);
+        lines << QString("Поиски: %1, найдено: %2").arg(stats.searches).arg(stats.searchHits);
+        lines << QString("Путь поиска: в среднем %1, p99 %2").arg(stats.meanPathLength(), 0, 'f', 1).arg(stats.pathPercentile(0.99));
+        lines << QString("Вращения: левые %1, правые %2, двойные %3").arg(stats.leftRotations).arg(stats.rightRotations).arg(stats.doubleRotations);
+        lines << QString("В transformToAVL: %1, перестроений: %2").arg(stats.transformRotations).arg(stats.rebuilds);
+        lines << QString("Перерисовок: %1, последняя %2 мкс").arg(paints).arg(lastPaintMicroseconds);
+
+        QFontMetrics metrics(painter.font());
+        int lineHeight = metrics.height();
+        int panelWidth = 0;
+        for (const QString& line : lines) {
+            panelWidth = std::max(panelWidth, metrics.horizontalAdvance(line));
+        }
+        QRect panel(8, 8, panelWidth + 16, lineHeight * lines.size() + 12);
+        statsPanel = panel.adjusted(-1, -1, 1, 1);
+        painter.setPen(Qt::gray);
+        painter.setBrush(QColor(255, 255, 255, 220));  // Полупрозрачный фон: дерево под панелью остаётся видно
+        painter.drawRect(panel);
         painter.setPen(Qt::black);
-        painter.drawText(QRectF(x - radius, y - radius, 2 * radius, 2 * radius), Qt::AlignCenter, QString::number(node->key));
-
-        if (node->left != nullptr) {
-            // Рассчитываем координаты для левого потомка
-            int leftX = x - spacing;
-            int leftY = y + levelHeight;
-            // Рисуем линию от текущего узла к левому потомку
-            painter.drawLine(x, y + radius, leftX, leftY);
-            // Рекурсивно вызываем drawTree для левого потомка
-            drawTree(painter, leftX, leftY, node->left, level + 1);
+        for (int i = 0; i < lines.size(); i++) {
+            painter.drawText(panel.left() + 8, panel.top() + 6 + lineHeight * (i + 1) - metrics.descent(), lines[i]);
         }
+    }
+#endif
+
+    // Функция для отрисовки части дерева в экранной области area. Обходятся только узлы в области: поддеревья
+    // за её краем пропускаются целиком, а поддеревья уже нескольких пикселей рисуются одним треугольником.
+    // Рёбра, круги и треугольники собираются в пакеты и рисуются тремя вызовами вместо вызова на каждый узел
+    void drawTree(QPainter& painter, const QRect& area) {
+        const double radius = IntLayout::Radius;
+        const IntLayout& layout = *snapshot->layout;
+        const IntLayout::Entries& nodes = layout.getNodes();
+        bool drawCircles = radius * zoom >= 2;  // Мельче круги неразличимы, узлы рисуются точками
+        bool drawLabels = radius * zoom >= 8;  // Подписи читаются только на крупных кругах
+
+        QVector<QLineF> edges;
+        QPainterPath circles;
+        QPainterPath subtrees;
+        QPolygonF points;
+        std::vector<std::pair<QPointF, int>> labels;
+
+        double left = (area.left() - offset.x()) / zoom;
+        double top = (area.top() - offset.y()) / zoom;
+        double right = (area.right() + 1 - offset.x()) / zoom;
+        double bottom = (area.bottom() + 1 - offset.y()) / zoom;
+        layout.visible(left, top, right, bottom, LodPixels / zoom,
+            [&](const LayoutPlacement& node) {
+                QPointF center(node.x, node.y);
+                edges.append(QLineF(QPointF(node.parentX, node.parentY), center));
+                if (drawCircles) {
+                    circles.addEllipse(center, radius, radius);
+                }
+                else {
+                    points.append(center);
+                }
+                if (drawLabels) {
+                    labels.push_back({ center, nodes[node.index].key });
+                }
+            },
+            [&](const LayoutPlacement& node) {
+                // Свёрнутое поддерево: треугольник от его корня до нижнего уровня во всю ширину поддерева
+                QPointF center(node.x, node.y);
+                edges.append(QLineF(QPointF(node.parentX, node.parentY), center));
+                QPolygonF triangle;
+                triangle << center << QPointF(node.minX, node.bottom) << QPointF(node.maxX, node.bottom) << center;
+                subtrees.addPolygon(triangle);
+            });
+
+        drawBatches(painter, edges, subtrees, circles, points, labels);
+    }
 
-        if (node->right != nullptr) {
-            // Рассчитываем координаты для правого потомка
-            int rightX = x + spacing;
-            int rightY = y + levelHeight;
-            // Рисуем линию от текущего узла к правому потомку
-            painter.drawLine(x, y + radius, rightX, rightY);
-            // Рекурсивно вызываем drawTree для правого потомка
-            drawTree(painter, rightX, rightY, node->right, level + 1);
+    // Функция для отрисовки кадра анимации: узлы копии в положении текущей доли шага. Узлы вне окна
+    // пропускаются; рёбра рисуются, только пока соседние столбцы различимы
+    void drawAnimation(QPainter& painter) {
+        const double radius = IntLayout::Radius;
+        bool drawCircles = radius * zoom >= 2;
+        bool drawLabels = radius * zoom >= 8;
+        bool drawEdges = IntLayout::Spacing * zoom >= LodPixels;
+        double t = stepRemaining == 0 && stepDuration > 0 ? std::min(1.0, stepClock.elapsed() / stepDuration) : 0.0;
+        t = t * t * (3 - 2 * t);  // Плавный разгон и торможение
+
+        QVector<QLineF> edges;
+        QPainterPath circles;
+        QPolygonF points;
+        std::vector<std::pair<QPointF, int>> labels;
+
+        double left = -offset.x() / zoom - radius;
+        double top = -offset.y() / zoom - radius;
+        double right = (width() - offset.x()) / zoom + radius;
+        double bottom = (height() - offset.y()) / zoom + radius;
+        replay.frame(t, [&](double x, double y, double parentX, double parentY, int key) {
+            if (drawEdges && std::max(x, parentX) >= left && std::min(x, parentX) <= right && std::max(y, parentY) >= top &&
+                std::min(y, parentY) <= bottom) {
+                edges.append(QLineF(QPointF(parentX, parentY), QPointF(x, y)));
+            }
+            if (x < left || x > right || y < top || y > bottom) {
+                return;
+            }
+            if (drawCircles) {
+                circles.addEllipse(QPointF(x, y), radius, radius);
+            }
+            else {
+                points.append(QPointF(x, y));
+            }
+            if (drawLabels) {
+                labels.push_back({ QPointF(x, y), key });
+            }
+        });
+        drawBatches(painter, edges, QPainterPath(), circles, points, labels);
+    }
+
+    // Функция для отрисовки собранных пакетов в мировых координатах: рёбра, свёрнутые поддеревья, круги,
+    // точки и подписи — по вызову на пакет
+    void drawBatches(QPainter& painter, const QVector<QLineF>& edges, const QPainterPath& subtrees, const QPainterPath& circles,
+                     const QPolygonF& points, const std::vector<std::pair<QPointF, int>>& labels) {
+        const double radius = IntLayout::Radius;
+        painter.save();
+        painter.translate(offset);
+        painter.scale(zoom, zoom);
+        QPen pen(Qt::black);
+        pen.setCosmetic(true);  // Толщина линий не зависит от масштаба
+        painter.setPen(pen);
+        painter.drawLines(edges);
+        painter.setBrush(Qt::lightGray);
+        painter.drawPath(subtrees);
+        painter.setBrush(Qt::white);
+        painter.drawPath(circles);
+        painter.drawPoints(points);
+        for (const std::pair<QPointF, int>& label : labels) {
+            // Помещаем текст (ключ узла) в центр круга
+            QPointF position = label.first;
+            painter.drawText(QRectF(position.x() - radius, position.y() - radius, 2 * radius, 2 * radius), Qt::AlignCenter, QString::number(label.second));
         }
+        painter.restore();
     }
 };
 
@@ -310,9 +617,33 @@ int main(int argc, char* argv[]) {
         bool ok;
         int key = QInputDialog::getInt(nullptr, "Поиск по ключу", "Ключ:", 0, INT_MIN, INT_MAX, 1, &ok);
         if (ok) {
-            bool found = binaryTreeWidget.searchNode(key);
-            QString message = found ? "Узел найден!" : "Узел не найден!";
-            QMessageBox::information(nullptr, "Результат поиска", message);
+            binaryTreeWidget.searchNode(key, [](bool found) {
+                QString message = found ? "Узел найден!" : "Узел не найден!";
+                QMessageBox::information(nullptr, "Результат поиска", message);
+            });
+        }
+    });
+
+    // Кнопка для импорта множества ключей из файла или генератора
+    QPushButton importButton("Импорт ключей");
+    QObject::connect(&importButton, &QPushButton::clicked, [&binaryTreeWidget]() {
+        QStringList sources = { "Из файла...", "Случайные ключи", "Ключи по возрастанию" };
+        bool ok;
+        QString source = QInputDialog::getItem(nullptr, "Импорт ключей", "Источник:", sources, 0, false, &ok);
+        if (!ok) {
+            return;
+        }
+        if (source == sources[0]) {
+            QString path = QFileDialog::getOpenFileName(nullptr, "Импорт ключей", QString(),
+                                                        "Ключи (*.txt *.tree);;Все файлы (*)");
+            if (!path.isEmpty()) {
+                binaryTreeWidget.importFile(path);
+            }
+            return;
+        }
+        int count = QInputDialog::getInt(nullptr, "Импорт ключей", "Количество:", 1000000, 1, 100000000, 1000, &ok);
+        if (ok) {
+            binaryTreeWidget.generateKeys(count, source == sources[2]);
         }
     });
 
@@ -338,6 +669,47 @@ int main(int argc, char* argv[]) {
         binaryTreeWidget.balanceTree();
     });
 
+    // Переключатель режима самобалансировки
+    QCheckBox autoBalanceCheckBox("Автобалансировка");
+    QObject::connect(&autoBalanceCheckBox, &QCheckBox::toggled, [&binaryTreeWidget](bool checked) {
+        binaryTreeWidget.setAutoBalance(checked);
+    });
+
+    // Переключатель анимации изменений
+    QCheckBox animationCheckBox("Анимация");
+    animationCheckBox.setChecked(true);
+    QObject::connect(&animationCheckBox, &QCheckBox::toggled, [&binaryTreeWidget](bool checked) {
+        binaryTreeWidget.setAnimation(checked);
+    });
+
+    // Полоса хода длинных операций и кнопка отмены, видны, пока операция идёт
+    QProgressBar progressBar;
+    QPushButton cancelButton("Отмена");
+    QObject::connect(&cancelButton, &QPushButton::clicked, [&binaryTreeWidget]() {
+        binaryTreeWidget.cancelOperations();
+    });
+    QHBoxLayout progressLayout;
+    progressLayout.addWidget(&progressBar);
+    progressLayout.addWidget(&cancelButton);
+    QWidget progressWidget;
+    progressWidget.setLayout(&progressLayout);
+    progressWidget.hide();
+    binaryTreeWidget.setProgressHandler([&progressWidget, &progressBar](const TreeProgress& progress) {
+        progressWidget.setVisible(!progress.finished);
+        if (progress.total == 0) {
+            progressBar.setRange(0, 0);  // Объём неизвестен: бегущая полоса
+        }
+        else {
+            progressBar.setRange(0, 1000);
+            progressBar.setValue(static_cast<int>(1000.0 * progress.done / progress.total));
+        }
+        progressBar.setFormat(QString::fromStdString(progress.operation) + ": %p%");
+        if (!progress.error.empty()) {
+            QMessageBox::warning(nullptr, QString::fromStdString(progress.operation),
+                                 QString::fromStdString(progress.error));
+        }
+    });
+
     // Создание основного Layout
     QVBoxLayout layout;
     layout.addWidget(&binaryTreeWidget);
@@ -347,10 +719,13 @@ int main(int argc, char* argv[]) {
     buttonLayout.addWidget(&insertButton);
     buttonLayout.addWidget(&deleteButton);
     buttonLayout.addWidget(&searchButton);
+    buttonLayout.addWidget(&importButton);
     buttonLayout.addWidget(&preOrderButton);
     buttonLayout.addWidget(&inOrderButton);
     buttonLayout.addWidget(&postOrderButton);
     buttonLayout.addWidget(&balanceButton);
+    buttonLayout.addWidget(&autoBalanceCheckBox);
+    buttonLayout.addWidget(&animationCheckBox);
 
     // Создание основного виджета и установка Layout кнопок
     QWidget mainWidget;
@@ -358,6 +733,7 @@ int main(int argc, char* argv[]) {
 
     // Добавление кнопочного Layout на основной Layout
     layout.addWidget(&mainWidget);
+    layout.addWidget(&progressWidget);
 
     // Создание окна и его отображение
     QWidget window;
@@ -8,11 +8,21 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# Счётчики операций дерева для панели статистики (TreeStats); без этой строки они не компилируются
+DEFINES += BINARYTREE_STATS
+
 SOURCES += \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
+    binarytree.h \
+    bufferedwriter.h \
+    frozentree.h \
+    threadpool.h \
+    treelayout.h \
+    treeengine.h \
+    treereplay.h \
     mainwindow.h
 
 FORMS += \
@@ -0,0 +1,332 @@
+#ifndef PERSISTENTTREE_H
+#define PERSISTENTTREE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Узел персистентного дерева. Узел, на который ссылается больше одного владельца, не меняется
+template <typename Key>
+struct PersistentNode {
+    Key key;
+    PersistentNode* left;
+    PersistentNode* right;
+    int height;
+    mutable std::atomic<std::size_t> refs;  // Число ссылок: из родителей, живого дерева и снимков
+
+    PersistentNode(const Key& key, PersistentNode* left, PersistentNode* right, int height)
+        : key(key), left(left), right(right), height(height), refs(0) {}
+};
+
+// Персистентное AVL-дерево-множество с копированием пути. Живое дерево меняется через insert и deleteNode,
+// snapshot() за O(1) возвращает снимок текущей версии. Снимок остаётся неизменным и читается, пока живое
+// дерево продолжает меняться: изменение копирует узлы пути, которые разделены со снимками, и переиспользует
+// остальные поддеревья. Узлы, на которые не ссылается ни одна версия, освобождаются подсчётом ссылок.
+// Пока снимков нет, узлы принадлежат только живому дереву и меняются на месте, без копирования.
+// Живое дерево (включая snapshot()) используется из одного потока, снимки можно читать и разрушать в любых
+template <typename Key, typename Compare = std::less<Key>>
+class PersistentTree {
+public:
+    typedef PersistentNode<Key> Node;
+
+    // Снимок версии дерева: лёгкий копируемый указатель на корень с подсчётом ссылок
+    class Snapshot {
+    public:
+        Snapshot() : rootNode(nullptr) {}
+
+        Snapshot(const Snapshot& other) : rootNode(other.rootNode), comp(other.comp) {
+            acquire(rootNode);
+        }
+
+        Snapshot(Snapshot&& other) noexcept : rootNode(other.rootNode), comp(std::move(other.comp)) {
+            other.rootNode = nullptr;
+        }
+
+        Snapshot& operator=(Snapshot other) noexcept {
+            std::swap(rootNode, other.rootNode);
+            std::swap(comp, other.comp);
+            return *this;
+        }
+
+        ~Snapshot() {
+            release(rootNode);
+        }
+
+        const Node* root() const {
+            return rootNode;
+        }
+
+        // Функция для поиска узла с заданным ключом в снимке
+        const Node* search(const Key& key) const {
+            return PersistentTree::find(rootNode, key, comp);
+        }
+
+        // Симметричный обход снимка с вызовом visit для каждого узла
+        template <typename Visitor>
+        void inOrderTraversal(Visitor visit) const {
+            PersistentTree::inOrder(rootNode, visit);
+        }
+
+    private:
+        friend class PersistentTree;
+
+        const Node* rootNode;
+        Compare comp;
+
+        Snapshot(const Node* root, const Compare& comp) : rootNode(root), comp(comp) {
+            acquire(rootNode);
+        }
+    };
+
+    explicit PersistentTree(const Compare& comp = Compare()) : root(nullptr), comp(comp) {}
+
+    ~PersistentTree() {
+        release(root);
+    }
+
+    PersistentTree(const PersistentTree&) = delete;
+    PersistentTree& operator=(const PersistentTree&) = delete;
+
+    // Функция для получения снимка текущей версии за O(1)
+    Snapshot snapshot() const {
+        return Snapshot(root, comp);
+    }
+
+    const Node* getRoot() const {
+        return root;
+    }
+
+    // Функция для вставки ключа, возвращает false, если ключ уже есть
+    bool insert(const Key& key) {
+        Node** link = &root;
+        path.clear();
+        while (*link != nullptr) {
+            own(link);  // Узлы пути будут меняться: разделённые со снимками копируются
+            path.push_back(link);
+            if (comp(key, (*link)->key)) {
+                link = &(*link)->left;
+            }
+            else if (comp((*link)->key, key)) {
+                link = &(*link)->right;
+            }
+            else {
+                return false;  // Скопированные узлы пути равны исходным, дерево не изменилось по содержанию
+            }
+        }
+        *link = new Node(key, nullptr, nullptr, 1);
+        acquire(*link);
+        retrace();
+        return true;
+    }
+
+    // Функция для удаления ключа, возвращает false, если ключа нет
+    bool deleteNode(const Key& key) {
+        if (find(root, key, comp) == nullptr) {
+            return false;  // Не копируем путь понапрасну
+        }
+        Node** link = &root;
+        path.clear();
+        own(link);
+        while (comp(key, (*link)->key) || comp((*link)->key, key)) {
+            path.push_back(link);
+            link = comp(key, (*link)->key) ? &(*link)->left : &(*link)->right;
+            own(link);
+        }
+
+        Node* node = *link;
+        if (node->left != nullptr && node->right != nullptr) {
+            // Два потомка: на место узла переставляется минимальный узел правого поддерева
+            path.push_back(link);
+            std::size_t belowNode = path.size();
+            Node** minLink = &node->right;
+            own(minLink);
+            while ((*minLink)->left != nullptr) {
+                path.push_back(minLink);
+                minLink = &(*minLink)->left;
+                own(minLink);
+            }
+
+            Node* minNode = *minLink;
+            *minLink = minNode->right;  // Ссылка на правого потомка переходит от minNode к его родителю
+            minNode->left = node->left;  // Ссылки на потомков переходят от удаляемого узла к minNode
+            minNode->right = node->right;
+            minNode->height = node->height;
+            *link = minNode;
+            if (path.size() > belowNode) {
+                path[belowNode] = &minNode->right;
+            }
+        }
+        else {
+            *link = node->left != nullptr ? node->left : node->right;
+        }
+        node->left = nullptr;  // Ссылки на потомков уже переданы, освобождается только сам узел
+        node->right = nullptr;
+        release(node);
+        retrace();
+        return true;
+    }
+
+    // Функция для поиска узла с заданным ключом в живом дереве
+    const Node* search(const Key& key) const {
+        return find(root, key, comp);
+    }
+
+    // Симметричный обход живого дерева
+    template <typename Visitor>
+    void inOrderTraversal(Visitor visit) const {
+        inOrder(root, visit);
+    }
+
+    // Функция для удаления всех ключей живого дерева, снимки не меняются
+    void clear() {
+        release(root);
+        root = nullptr;
+    }
+
+private:
+    Node* root;  // Корень живой версии, на него приходится одна ссылка
+    Compare comp;
+    std::vector<Node**> path;  // Путь поиска последней операции: ссылки на собственные узлы
+
+    static void acquire(const Node* node) {
+        if (node != nullptr) {
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Функция для снятия ссылки: узел без ссылок освобождается вместе со ссылками на потомков, без рекурсии
+    static void release(const Node* node) {
+        std::vector<const Node*> stack;
+        while (node != nullptr) {
+            if (node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (node->left != nullptr) {
+                    stack.push_back(node->left);
+                }
+                if (node->right != nullptr) {
+                    stack.push_back(node->right);
+                }
+                delete node;
+            }
+            if (stack.empty()) {
+                break;
+            }
+            node = stack.back();
+            stack.pop_back();
+        }
+    }
+
+    // Функция, делающая узел по ссылке link собственным для живого дерева. Родитель узла уже собственный,
+    // поэтому узел с единственной ссылкой принадлежит только живому дереву и его можно менять.
+    // Разделённый узел копируется: копия ссылается на тех же потомков, оригинал остаётся снимкам
+    void own(Node** link) {
+        Node* node = *link;
+        if (node == nullptr || node->refs.load(std::memory_order_acquire) == 1) {
+            return;
+        }
+        Node* copy = new Node(node->key, node->left, node->right, node->height);
+        acquire(copy->left);
+        acquire(copy->right);
+        acquire(copy);
+        *link = copy;
+        release(node);
+    }
+
+    static int getHeight(const Node* node) {
+        return node != nullptr ? node->height : 0;
+    }
+
+    static void updateHeight(Node* node) {
+        node->height = 1 + std::max(getHeight(node->left), getHeight(node->right));
+    }
+
+    static Node* rightRotate(Node* y) {
+        Node* x = y->left;
+        y->left = x->right;
+        x->right = y;
+        updateHeight(y);
+        updateHeight(x);
+        return x;
+    }
+
+    static Node* leftRotate(Node* x) {
+        Node* y = x->right;
+        x->right = y->left;
+        y->left = x;
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    // Функция для восстановления AVL-свойства в собственном узле. Вращения меняют потомков и внуков,
+    // поэтому перед вращением они тоже становятся собственными (при удалении это поддерево вне пути)
+    Node* rebalance(Node* node) {
+        updateHeight(node);
+        int balance = getHeight(node->left) - getHeight(node->right);
+        if (balance > 1) {
+            own(&node->left);
+            if (getHeight(node->left->right) > getHeight(node->left->left)) {
+                own(&node->left->right);
+                node->left = leftRotate(node->left);
+            }
+            node = rightRotate(node);
+        }
+        else if (balance < -1) {
+            own(&node->right);
+            if (getHeight(node->right->left) > getHeight(node->right->right)) {
+                own(&node->right->left);
+                node->right = rightRotate(node->right);
+            }
+            node = leftRotate(node);
+        }
+        return node;
+    }
+
+    // Функция для балансировки пути снизу вверх с ранней остановкой, как в BinaryTree
+    void retrace() {
+        while (!path.empty()) {
+            Node** link = path.back();
+            path.pop_back();
+            int oldHeight = (*link)->height;
+            *link = rebalance(*link);
+            if ((*link)->height == oldHeight) {
+                break;
+            }
+        }
+    }
+
+    static const Node* find(const Node* node, const Key& key, const Compare& comp) {
+        while (node != nullptr) {
+            if (comp(key, node->key)) {
+                node = node->left;
+            }
+            else if (comp(node->key, key)) {
+                node = node->right;
+            }
+            else {
+                return node;
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename Visitor>
+    static void inOrder(const Node* root, Visitor& visit) {
+        std::vector<const Node*> stack;
+        const Node* node = root;
+        while (node != nullptr || !stack.empty()) {
+            while (node != nullptr) {
+                stack.push_back(node);
+                node = node->left;
+            }
+            node = stack.back();
+            stack.pop_back();
+            visit(node);
+            node = node->right;
+        }
+    }
+};
+
+#endif // PERSISTENTTREE_H
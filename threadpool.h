@@ -0,0 +1,202 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Пул потоков с перехватом работы (work stealing). У каждого рабочего потока своя очередь:
+// свои задачи он берёт с конца (последние добавленные, их данные ещё в кэше), а когда очередь
+// пуста — забирает самые старые задачи с начала очередей других потоков
+class ThreadPool {
+public:
+    // Конструктор: threads рабочих потоков, по умолчанию по числу аппаратных потоков
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) : queued(0), stopping(false) {
+        if (threads == 0) {
+            threads = 1;
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            queues.emplace_back(new Queue());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    // Деструктор дожидается выполнения всех поставленных задач
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            stopping = true;
+        }
+        sleepCondition.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Общий пул процесса, создаётся при первом обращении
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // Число рабочих потоков
+    std::size_t size() const {
+        return workers.size();
+    }
+
+    // Группа задач: run ставит задачу в пул, wait ждёт завершения всех задач группы.
+    // Ожидающий поток сам выполняет задачи из пула, поэтому wait можно вызывать и внутри задачи.
+    // Первое исключение, выброшенное задачей, передаётся из wait
+    class TaskGroup {
+    public:
+        explicit TaskGroup(ThreadPool& pool = ThreadPool::instance()) : pool(pool), pending(0) {}
+
+        ~TaskGroup() {
+            waitAll();  // Задачи ссылаются на группу, поэтому разрушать её раньше нельзя
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        template <typename Function>
+        void run(Function task) {
+            pending.fetch_add(1, std::memory_order_relaxed);
+            pool.push([this, task]() mutable {
+                try {
+                    task();
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                pending.fetch_sub(1, std::memory_order_release);
+            });
+        }
+
+        void wait() {
+            waitAll();
+            if (error) {
+                std::exception_ptr thrown = error;
+                error = nullptr;
+                std::rethrow_exception(thrown);
+            }
+        }
+
+    private:
+        ThreadPool& pool;
+        std::atomic<std::size_t> pending;  // Число поставленных и ещё не завершённых задач
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        void waitAll() {
+            while (pending.load(std::memory_order_acquire) != 0) {
+                if (!pool.runOne()) {
+                    std::this_thread::yield();  // Оставшиеся задачи группы выполняются другими потоками
+                }
+            }
+        }
+    };
+
+private:
+    // Очередь рабочего потока на отдельной строке кэша
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Принадлежность текущего потока пулу: рабочие потоки кладут задачи в свою очередь
+    struct WorkerIdentity {
+        const ThreadPool* pool;
+        std::size_t index;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> queued;  // Число задач во всех очередях
+    std::atomic<std::size_t> nextQueue{ 0 };  // Очередь для задач из потоков вне пула, по кругу
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    bool stopping;
+
+    static WorkerIdentity& identity() {
+        thread_local WorkerIdentity current = { nullptr, 0 };
+        return current;
+    }
+
+    void push(std::function<void()> task) {
+        WorkerIdentity& self = identity();
+        std::size_t index = self.pool == this ? self.index : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);  // Рабочий не пропустит пробуждение между проверкой и ожиданием
+        }
+        sleepCondition.notify_one();
+    }
+
+    // Функция для выполнения одной задачи: сначала из своей очереди с конца, затем чужие с начала
+    bool runOne() {
+        if (queued.load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+        WorkerIdentity& self = identity();
+        std::size_t start = self.pool == this ? self.index : 0;
+        std::function<void()> task;
+        for (std::size_t i = 0; i < queues.size(); i++) {
+            Queue& queue = *queues[(start + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0 && self.pool == this) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else {
+                task = std::move(queue.tasks.front());  // Перехват: самая старая задача обычно самая крупная
+                queue.tasks.pop_front();
+            }
+            break;
+        }
+        if (!task) {
+            return false;
+        }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        task();
+        return true;
+    }
+
+    void work(std::size_t index) {
+        identity() = { this, index };
+        while (true) {
+            if (runOne()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) != 0; });
+            if (stopping && queued.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,351 @@
+#ifndef TREEENGINE_H
+#define TREEENGINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "binarytree.h"
+#include "bufferedwriter.h"
+#include "treelayout.h"
+
+// Снимок дерева для отрисовки. После публикации не меняется, поэтому читается из любого потока без блокировок
+template <typename Key>
+struct TreeSnapshot {
+    std::uint64_t version = 0;  // Номер снимка, растёт с каждой публикацией
+    std::shared_ptr<const TreeLayout<Key>> layout = std::make_shared<const TreeLayout<Key>>();  // Делит блоки записей с раскладкой рабочего потока
+    TreeStats stats;  // Счётчики операций и размер; высота взята из раскладки
+    bool rebuilt = true;  // Раскладка с прошлого снимка собрана заново: перерисовать всё
+    LayoutChange change;  // Иначе — области, изменившиеся с прошлого снимка
+    std::shared_ptr<const TreeEventLog<Key>> events;  // Изменения формы с прошлого снимка, если журнал ведётся
+};
+
+// Ход длинной операции
+struct TreeProgress {
+    std::string operation;
+    std::size_t done;
+    std::size_t total;  // 0, если объём работы заранее неизвестен
+    bool finished;
+    bool cancelled;
+    std::string error;  // Непустая, если операция прервана ошибкой
+};
+
+// Дерево в отдельном рабочем потоке. Операции ставятся в очередь и выполняются по порядку, вызывающий
+// поток не ждёт. После изменений рабочий поток публикует снимок раскладки через publish — не чаще раза
+// в PublishInterval, пока очередь не пуста, и сразу, когда она опустела. Длинные операции сообщают о ходе
+// через progress и прерываются cancel. Обработчики вызываются в рабочем потоке
+template <typename Key, typename Compare = std::less<Key>>
+class TreeEngine {
+public:
+    typedef BinaryTree<Key, void, Compare> Tree;
+    typedef TreeSnapshot<Key> Snapshot;
+    typedef std::function<void(std::shared_ptr<const Snapshot>)> SnapshotHandler;
+    typedef std::function<void(const TreeProgress&)> ProgressHandler;
+
+    static constexpr std::chrono::milliseconds PublishInterval{ 33 };  // Около 30 снимков в секунду при потоке операций
+    static constexpr std::size_t ChunkSize = 1 << 16;  // Шаг длинных операций между проверками отмены
+    static constexpr std::size_t MaxChangedAreas = 512;  // Больше областей — проще перерисовать всё
+    static constexpr std::size_t MaxEvents = 1 << 20;  // Наибольший журнал изменений на снимок
+
+    TreeEngine(SnapshotHandler publish, ProgressHandler progress)
+        : publish(std::move(publish)), progress(std::move(progress)), submitted(0), cancelledUpTo(0), stopping(false) {
+        log.limit = MaxEvents;
+        worker = std::thread([this] { work(); });
+    }
+
+    // Деструктор отменяет операции в очереди и дожидается текущей
+    ~TreeEngine() {
+        cancel();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        worker.join();
+    }
+
+    TreeEngine(const TreeEngine&) = delete;
+    TreeEngine& operator=(const TreeEngine&) = delete;
+
+    void insert(const Key& key) {
+        submit([this, key](std::uint64_t) {
+            tree.root = tree.insert(tree.root, key);
+            layoutChanged();
+        });
+    }
+
+    void remove(const Key& key) {
+        submit([this, key](std::uint64_t) {
+            tree.root = tree.deleteNode(tree.root, key);
+            layoutChanged();
+        });
+    }
+
+    // Поиск: done(найден ли ключ) вызывается в рабочем потоке
+    void search(const Key& key, std::function<void(bool)> done) {
+        submit([this, key, done](std::uint64_t) {
+            done(tree.search(tree.root, key) != nullptr);
+        });
+    }
+
+    // Включение режима самобалансировки, уже построенное дерево сначала приводится к AVL
+    void setAutoBalance(bool enabled) {
+        submit([this, enabled](std::uint64_t) {
+            tree.autoBalance = enabled;
+            if (enabled) {
+                rebuild("Балансировка");
+            }
+        });
+    }
+
+    // Включение журнала изменений: снимки несут события с прошлого снимка (вставки, удаления, вращения),
+    // по которым можно показать переход между ними. Журнал неполный, если изменения были до включения,
+    // после пакетной вставки или при превышении MaxEvents
+    void setRecordEvents(bool enabled) {
+        submit([this, enabled](std::uint64_t) {
+            if (enabled && tree.events == nullptr) {
+                log.clear();
+                if (changed) {
+                    log.invalidate();  // Изменения после прошлого снимка уже не записать
+                }
+                tree.events = &log;
+            }
+            else if (!enabled) {
+                tree.events = nullptr;
+            }
+        });
+    }
+
+    // Балансировка перестройкой. Сама перестройка не прерывается: отмена действует, пока она ждёт в очереди
+    void balance() {
+        submit([this](std::uint64_t) {
+            rebuild("Балансировка");
+        });
+    }
+
+    // Вставка пачки ключей. Пачка не меньше дерева сливается с ним одним insertBatch (дерево получается
+    // сбалансированным), меньшая вставляется по ключу шагами по ChunkSize с отчётом и проверкой отмены.
+    // Раскладка в обоих случаях собирается один раз, после всей пачки
+    void insertKeys(std::vector<Key> keys) {
+        auto shared = std::make_shared<std::vector<Key>>(std::move(keys));
+        submit([this, shared](std::uint64_t ticket) {
+            insertAll(*shared, ticket);
+        });
+    }
+
+    // Импорт: ключи получаются вызовом source в рабочем потоке (чтение файла, генерация) и вставляются
+    // как в insertKeys. Исключение из source прерывает импорт и передаётся в progress как ошибка
+    void loadKeys(std::function<std::vector<Key>()> source) {
+        submit([this, source](std::uint64_t ticket) {
+            const char* operation = "Чтение ключей";
+            std::vector<Key> keys;
+            report(operation, 0, 0, false, false);
+            try {
+                keys = source();
+            }
+            catch (const std::exception& error) {
+                report(operation, 0, 0, true, false, error.what());
+                return;
+            }
+            if (!cancelled(ticket)) {
+                insertAll(keys, ticket);
+            }
+            else {
+                report(operation, 0, 0, true, true);
+            }
+        });
+    }
+
+    // Выгрузка ключей в порядке order блоками в sink(данные, размер), sink вызывается в рабочем потоке
+    void traverse(TraversalOrder order, std::function<void(const char*, std::size_t)> sink) {
+        submit([this, order, sink](std::uint64_t ticket) {
+            struct Cancelled {};
+            const char* operation = "Обход";
+            std::size_t total = tree.getSize(tree.root);
+            std::size_t done = 0;
+            BufferedWriter out(sink);
+            try {
+                tree.traverse(tree.root, order, [&](const typename Tree::Node* node) {
+                    out << node->key;
+                    out.put(' ');
+                    if (++done % ChunkSize == 0) {
+                        if (cancelled(ticket)) {
+                            throw Cancelled();  // Обход дерева не прерывается иначе как исключением
+                        }
+                        report(operation, done, total, false, false);
+                    }
+                });
+            }
+            catch (const Cancelled&) {
+            }
+            out.flush();
+            report(operation, done, total, true, done < total);
+        });
+    }
+
+    // Функция для отмены всех уже поставленных операций: ждущие пропускаются, текущая длинная
+    // операция останавливается на ближайшей проверке
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelledUpTo = submitted;
+    }
+
+private:
+    struct Task {
+        std::uint64_t ticket;  // Номер операции в порядке постановки
+        std::function<void(std::uint64_t)> run;
+    };
+
+    SnapshotHandler publish;
+    ProgressHandler progress;
+
+    // Состояние рабочего потока, другие потоки его не трогают
+    Tree tree;
+    TreeLayout<Key> layout;
+    LayoutChange pending;  // Изменения раскладки с прошлого снимка
+    TreeEventLog<Key> log;  // Журнал изменений с прошлого снимка, ведётся, если tree.events указывает на него
+    bool rebuilt = true;
+    bool changed = false;
+    std::uint64_t version = 0;
+    std::chrono::steady_clock::time_point lastPublish;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Task> queue;
+    std::uint64_t submitted;
+    std::atomic<std::uint64_t> cancelledUpTo;
+    bool stopping;
+    std::thread worker;  // Последним: поток стартует, когда остальные поля уже созданы
+
+    void submit(std::function<void(std::uint64_t)> run) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back({ ++submitted, std::move(run) });
+        }
+        wake.notify_one();
+    }
+
+    bool cancelled(std::uint64_t ticket) const {
+        return ticket <= cancelledUpTo.load(std::memory_order_relaxed);
+    }
+
+    void report(const char* operation, std::size_t done, std::size_t total, bool finished, bool wasCancelled,
+                const char* error = "") {
+        if (progress) {
+            progress({ operation, done, total, finished, wasCancelled, error });
+        }
+    }
+
+    void work() {
+        while (true) {
+            Task task;
+            bool idle;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (stopping) {
+                    return;
+                }
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            if (!cancelled(task.ticket)) {
+                task.run(task.ticket);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                idle = queue.empty();
+            }
+            if (changed && (idle || std::chrono::steady_clock::now() - lastPublish >= PublishInterval)) {
+                publishSnapshot();
+            }
+        }
+    }
+
+    void insertAll(const std::vector<Key>& batch, std::uint64_t ticket) {
+        const char* operation = "Вставка ключей";
+        if (batch.size() >= tree.getSize(tree.root)) {
+            report(operation, 0, 0, false, false);
+            tree.root = tree.insertBatch(tree.root, batch.begin(), batch.end());
+            rebuildLayout();
+            report(operation, batch.size(), batch.size(), true, false);
+            return;
+        }
+        std::size_t done = 0;
+        while (done < batch.size() && !cancelled(ticket)) {
+            std::size_t end = std::min(batch.size(), done + ChunkSize);
+            for (; done < end; done++) {
+                tree.root = tree.insert(tree.root, batch[done]);
+            }
+            report(operation, done, batch.size(), false, false);
+        }
+        rebuildLayout();
+        report(operation, done, batch.size(), true, done < batch.size());
+    }
+
+    void rebuild(const char* operation) {
+        report(operation, 0, 0, false, false);
+        tree.root = tree.rebuildBalanced(tree.root);
+        rebuildLayout();
+        report(operation, 1, 1, true, false);
+    }
+
+    // Функция для правки раскладки после одной вставки или удаления
+    void layoutChanged() {
+        LayoutChange change = layout.update(tree, tree.root);
+        changed = true;
+        if (rebuilt) {
+            return;  // Следующий снимок и так перерисуется целиком
+        }
+        pending.areas.insert(pending.areas.end(), change.areas.begin(), change.areas.end());
+        pending.subtrees.insert(pending.subtrees.end(), change.subtrees.begin(), change.subtrees.end());
+        if (pending.areas.size() + pending.subtrees.size() > MaxChangedAreas) {
+            rebuilt = true;
+            pending = LayoutChange();
+        }
+    }
+
+    void rebuildLayout() {
+        layout.build(tree, tree.root);
+        rebuilt = true;
+        changed = true;
+        pending = LayoutChange();
+    }
+
+    // Функция для публикации снимка. Раскладка снимка делит блоки записей с раскладкой рабочего потока, поэтому
+    // публикация стоит O(n / BlockSize), а не копии всех записей: рабочий поток копирует блок, только когда правит его
+    void publishSnapshot() {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->version = ++version;
+        snapshot->layout = std::make_shared<const TreeLayout<Key>>(layout.share());
+        snapshot->stats = tree.stats(false);  // Высота берётся из раскладки, без обхода дерева
+        snapshot->stats.height = layout.empty() ? 0 : static_cast<int>(layout.getNodes()[0].levels);
+        snapshot->rebuilt = rebuilt;
+        snapshot->change = std::move(pending);
+        pending = LayoutChange();
+        if (tree.events != nullptr) {
+            snapshot->events = std::make_shared<TreeEventLog<Key>>(std::move(log));
+            log.clear();
+        }
+        rebuilt = false;
+        changed = false;
+        lastPublish = std::chrono::steady_clock::now();
+        if (publish) {
+            publish(std::move(snapshot));
+        }
+    }
+};
+
+#endif // TREEENGINE_H
@@ -0,0 +1,385 @@
+#ifndef TREEIO_H
+#define TREEIO_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX  // Иначе макросы min и max из windows.h ломают std::min и std::max
+#endif
+#include <windows.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "binarytree.h"
+#include "commandreader.h"
+
+// Заголовок файла дерева. За ним идут count ключей в порядке возрастания, начиная со смещения 64,
+// поэтому отображённый в память файл сразу пригоден для двоичного поиска
+struct TreeFileHeader {
+    char magic[8];  // "BTREEKEY"
+    std::uint32_t version;  // Версия формата
+    std::uint32_t keySize;  // sizeof(Key) записавшей программы
+    std::uint64_t count;  // Число ключей
+    std::uint64_t checksum;  // Контрольная сумма ключей (treeChecksum)
+    std::uint32_t byteOrder;  // ByteOrderMark в порядке байтов записавшей машины
+    std::uint8_t reserved[28];
+};
+
+static_assert(sizeof(TreeFileHeader) == 64, "TreeFileHeader must stay 64 bytes");
+
+const std::uint32_t TreeFileVersion = 1;
+const std::uint32_t ByteOrderMark = 0x01020304;
+
+// Функция для подсчёта контрольной суммы: FNV-1a по 64-битным словам (хвост дополняется нулями).
+// state позволяет считать сумму по частям: результат для частей равен результату для всего массива,
+// если все части, кроме последней, кратны 8 байтам
+inline std::uint64_t treeChecksum(const void* data, std::size_t bytes, std::uint64_t state = 0xcbf29ce484222325ull) {
+    const unsigned char* bytesData = static_cast<const unsigned char*>(data);
+    std::size_t words = bytes / 8;
+    for (std::size_t i = 0; i < words; i++) {
+        std::uint64_t word;
+        std::memcpy(&word, bytesData + i * 8, 8);
+        state = (state ^ word) * 0x100000001b3ull;
+    }
+    if (bytes % 8 != 0) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, bytesData + words * 8, bytes % 8);
+        state = (state ^ word) * 0x100000001b3ull;
+    }
+    return state;
+}
+
+// Функция для проверки заголовка: формат, размер ключа и порядок байтов должны совпадать с текущей программой
+template <typename Key>
+void checkTreeFileHeader(const TreeFileHeader& header, std::uint64_t fileSize, const std::string& path) {
+    if (std::memcmp(header.magic, "BTREEKEY", 8) != 0) {
+        throw std::runtime_error(path + ": not a tree file");
+    }
+    if (header.version != TreeFileVersion) {
+        throw std::runtime_error(path + ": unsupported tree file version " + std::to_string(header.version));
+    }
+    if (header.keySize != sizeof(Key) || header.byteOrder != ByteOrderMark) {
+        throw std::runtime_error(path + ": key size or byte order does not match");
+    }
+    // Число ключей сравнивается с местом в файле до умножения: count из повреждённого файла может переполнить произведение
+    if (fileSize < sizeof(TreeFileHeader) || header.count > (fileSize - sizeof(TreeFileHeader)) / sizeof(Key)
+        || fileSize - sizeof(TreeFileHeader) != header.count * sizeof(Key)) {
+        throw std::runtime_error(path + ": file is truncated");
+    }
+}
+
+// Функция для сброса записанных данных файла на диск
+inline bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return ::fsync(::fileno(file)) == 0;
+#endif
+}
+
+// Функция для сброса на диск каталога файла path, чтобы пережило сбой и переименование в нём.
+// В Windows каталоги так не сбрасываются, переименование сохраняется файловой системой само
+inline bool syncDirectory(const std::string& path) {
+#if defined(_WIN32)
+    (void)path;
+    return true;
+#else
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int descriptor = ::open(directory.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool ok = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    return ok;
+#endif
+}
+
+// Функция для замены файла to файлом from одной операцией: при сбое на месте to остаётся один из двух файлов.
+// В Windows rename не заменяет существующий файл, поэтому используется MoveFileExW; имена переводятся из кодовой
+// страницы ANSI, как их понимают fopen и CreateFileA
+inline bool replaceFile(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+    auto widen = [](const std::string& name) {
+        int length = MultiByteToWideChar(CP_ACP, 0, name.c_str(), -1, nullptr, 0);
+        std::wstring wide(length > 0 ? length : 1, L'\0');
+        if (length > 0) {
+            MultiByteToWideChar(CP_ACP, 0, name.c_str(), -1, &wide[0], length);
+        }
+        return wide;
+    };
+    std::wstring wideFrom = widen(from);
+    std::wstring wideTo = widen(to);
+    return MoveFileExW(wideFrom.c_str(), wideTo.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+// Функция для сохранения ключей дерева в файл. Ключи пишутся в порядке возрастания блоками, файл сначала
+// создаётся рядом под временным именем и переименовывается, поэтому при сбое старый файл не портится
+template <typename Key, typename Compare, typename Allocator>
+void saveTree(const BinaryTree<Key, void, Compare, Allocator>& tree, const std::string& path) {
+    static_assert(std::is_trivially_copyable<Key>::value, "saveTree stores keys as raw bytes");
+    typedef typename BinaryTree<Key, void, Compare, Allocator>::Node Node;
+
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error(temporary + ": cannot open for writing");
+    }
+
+    TreeFileHeader header = {};
+    std::memcpy(header.magic, "BTREEKEY", 8);
+    header.version = TreeFileVersion;
+    header.keySize = sizeof(Key);
+    header.byteOrder = ByteOrderMark;
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;  // Заголовок перезаписывается в конце
+
+    const std::size_t BlockKeys = 8192;  // Ключей в одном блоке записи; размер блока кратен 8 байтам
+    std::vector<Key> block;
+    block.reserve(BlockKeys);
+    std::uint64_t checksum = 0xcbf29ce484222325ull;
+    auto flush = [&] {
+        checksum = treeChecksum(block.data(), block.size() * sizeof(Key), checksum);
+        ok = ok && std::fwrite(block.data(), sizeof(Key), block.size(), file) == block.size();
+        header.count += block.size();
+        block.clear();
+    };
+    tree.inOrderTraversal(tree.root, [&](const Node* node) {
+        block.push_back(node->key);
+        if (block.size() == BlockKeys) {
+            flush();
+        }
+    });
+    flush();
+
+    header.checksum = checksum;
+    ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && syncFile(file);  // Данные должны оказаться на диске раньше, чем файл заменит прежний
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error(temporary + ": write failed");
+    }
+    if (!replaceFile(temporary, path)) {
+        std::remove(temporary.c_str());
+        throw std::runtime_error(path + ": cannot replace file");
+    }
+    syncDirectory(path);
+}
+
+// Отображённый в память файл дерева только для чтения. Открытие читает лишь заголовок,
+// страницы с ключами подгружаются системой при первом обращении, поэтому открытие занимает O(1)
+// независимо от размера файла. Поиск — двоичный по упорядоченному массиву ключей
+template <typename Key, typename Compare = std::less<Key>>
+class MappedTree {
+public:
+    explicit MappedTree(const std::string& path, const Compare& comp = Compare()) : comp(comp) {
+        static_assert(std::is_trivially_copyable<Key>::value, "MappedTree reads keys as raw bytes");
+        std::uint64_t fileSize = map(path);
+        if (fileSize < sizeof(TreeFileHeader)) {
+            unmap();
+            throw std::runtime_error(path + ": not a tree file");
+        }
+        std::memcpy(&header, data, sizeof(header));
+        try {
+            checkTreeFileHeader<Key>(header, fileSize, path);
+        }
+        catch (...) {
+            unmap();
+            throw;
+        }
+        keys = reinterpret_cast<const Key*>(static_cast<const char*>(data) + sizeof(TreeFileHeader));
+    }
+
+    ~MappedTree() {
+        unmap();
+    }
+
+    MappedTree(const MappedTree&) = delete;
+    MappedTree& operator=(const MappedTree&) = delete;
+
+    std::size_t size() const {
+        return header.count;
+    }
+
+    // Ключи в порядке возрастания
+    const Key* begin() const {
+        return keys;
+    }
+
+    const Key* end() const {
+        return keys + header.count;
+    }
+
+    // Функция для проверки контрольной суммы: читает весь файл, поэтому вызывается отдельно от открытия
+    bool verify() const {
+        return treeChecksum(keys, header.count * sizeof(Key)) == header.checksum;
+    }
+
+    // Функция для поиска наименьшего ключа, не меньшего key; end(), если такого нет.
+    // Двоичный поиск без ветвлений: на каждом шаге заранее подгружаются обе возможные середины следующего шага
+    const Key* lowerBound(const Key& key) const {
+        const Key* base = keys;
+        std::size_t length = header.count;
+        if (length == 0) {
+            return end();
+        }
+        while (length > 1) {
+            std::size_t half = length / 2;
+#if defined(__GNUC__)
+            __builtin_prefetch(base + half / 2);
+            __builtin_prefetch(base + half + half / 2);
+#endif
+            base = comp(base[half - 1], key) ? base + half : base;
+            length -= half;
+        }
+        return comp(*base, key) ? base + 1 : base;
+    }
+
+    // Функция для поиска ключа, возвращает указатель на ключ в отображении или nullptr
+    const Key* search(const Key& key) const {
+        const Key* found = lowerBound(key);
+        return found != end() && !comp(key, *found) ? found : nullptr;
+    }
+
+private:
+    Compare comp;
+    TreeFileHeader header;
+    const void* data = nullptr;
+    std::size_t mappedSize = 0;
+    const Key* keys = nullptr;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    // Функция для отображения файла в память, возвращает размер файла
+    std::uint64_t map(const std::string& path) {
+#if defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+        LARGE_INTEGER size;
+        if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+            unmap();
+            throw std::runtime_error(path + ": cannot open");
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (data == nullptr) {
+            unmap();
+            throw std::runtime_error(path + ": cannot map");
+        }
+        mappedSize = static_cast<std::size_t>(size.QuadPart);
+#else
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        struct stat status;
+        if (descriptor < 0 || ::fstat(descriptor, &status) != 0) {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+            throw std::runtime_error(path + ": cannot open");
+        }
+        mappedSize = static_cast<std::size_t>(status.st_size);
+        void* address = mappedSize != 0 ? ::mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, descriptor, 0) : MAP_FAILED;
+        ::close(descriptor);  // Отображение остаётся действительным и после закрытия дескриптора
+        if (address == MAP_FAILED) {
+            mappedSize = 0;
+            throw std::runtime_error(path + ": cannot map");
+        }
+        ::madvise(address, mappedSize, MADV_RANDOM);  // Поиск читает страницы вразброс, упреждающее чтение не поможет
+        data = address;
+#endif
+        return mappedSize;
+    }
+
+    void unmap() {
+#if defined(_WIN32)
+        if (data != nullptr) {
+            UnmapViewOfFile(data);
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data != nullptr) {
+            ::munmap(const_cast<void*>(data), mappedSize);
+        }
+#endif
+        data = nullptr;
+        mappedSize = 0;
+    }
+};
+
+// Функция для загрузки дерева из файла: прежние узлы удаляются, ключи проверяются по контрольной сумме
+// и строятся в сбалансированное дерево за O(n) прямо из отображения файла, без промежуточной копии
+template <typename Key, typename Compare, typename Allocator>
+void loadTree(BinaryTree<Key, void, Compare, Allocator>& tree, const std::string& path) {
+    MappedTree<Key, Compare> mapped(path);
+    if (!mapped.verify()) {
+        throw std::runtime_error(path + ": checksum mismatch");
+    }
+    tree.root = tree.bulkLoad(mapped.begin(), mapped.end());
+}
+
+// Функция для чтения ключей для импорта. Файл дерева (начинается с "BTREEKEY") читается через отображение
+// с проверкой контрольной суммы, любой другой — как текст: числа через пробелы, запятые или с новой строки,
+// после '#' — комментарий. Ключи возвращаются в порядке файла
+template <typename Key>
+std::vector<Key> readKeys(const std::string& path) {
+    char magic[8] = {};
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        throw std::runtime_error(path + ": cannot open for reading");
+    }
+    bool treeFile = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::memcmp(magic, "BTREEKEY", 8) == 0;
+    std::fclose(file);
+    if (treeFile) {
+        MappedTree<Key> mapped(path);
+        if (!mapped.verify()) {
+            throw std::runtime_error(path + ": checksum mismatch");
+        }
+        return std::vector<Key>(mapped.begin(), mapped.end());
+    }
+
+    CommandReader reader(path);
+    std::vector<std::string_view> tokens;
+    std::vector<Key> keys;
+    while (reader.next(tokens)) {
+        for (std::string_view token : tokens) {
+            Key key;
+            if (!parseToken(token, key)) {
+                throw std::runtime_error(path + ": line " + std::to_string(reader.line()) + ": not a key");
+            }
+            keys.push_back(key);
+        }
+    }
+    return keys;
+}
+
+#endif // TREEIO_H
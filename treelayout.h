@@ -0,0 +1,497 @@
+#ifndef TREELAYOUT_H
+#define TREELAYOUT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Запись раскладки об узле дерева. Положение узла не хранится: столбец и уровень выводятся при обходе из
+// размеров поддеревьев, поэтому вставка или удаление ключа меняет записи только на пути к нему
+template <typename Key>
+struct LayoutNode {
+    const void* node;  // Узел дерева, по которому построена запись: по нему update узнаёт неизменившиеся узлы
+    Key key;
+    std::uint32_t size;  // Узлов в поддереве: поддерево занимает индексы [i, i + size)
+    std::uint32_t leftSize;  // Узлов в левом поддереве: левый потомок — запись i + 1, правый — i + 1 + leftSize
+    std::uint32_t levels;  // Высота поддерева в уровнях
+};
+
+// Положение узла, вычисленное при обходе раскладки, в мировых единицах
+struct LayoutPlacement {
+    std::size_t index;  // Индекс записи узла
+    double x;  // Центр узла
+    double y;
+    double parentX;  // Центр родителя, у корня совпадает с центром узла
+    double parentY;
+    double minX;  // Границы поддерева узла
+    double maxX;
+    double bottom;
+};
+
+// Прямоугольник в мировых единицах, стороны могут быть бесконечными
+struct LayoutRect {
+    double left;
+    double top;
+    double right;
+    double bottom;
+};
+
+// Области раскладки, изменившиеся после update. Вне areas старая и новая картинки совпадают.
+// subtrees — поддеревья узлов на пути изменения: они меняют вид, только если рисуются свёрнутыми
+struct LayoutChange {
+    std::vector<LayoutRect> areas;
+    std::vector<LayoutRect> subtrees;
+};
+
+template <typename Key>
+class TreeLayout;
+
+// Записи раскладки, разбитые на блоки примерно по BlockSize. Блоки делятся между раскладкой и её копиями
+// (см. share) и копируются перед первой правкой после share: копия раскладки для снимка стоит O(n / BlockSize),
+// а правка копирует только задетые блоки. Замена отрезка записей сдвигает записи только внутри своих блоков,
+// а не весь хвост массива. Запись по индексу находится двоичным поиском по началам блоков
+template <typename Key>
+class LayoutEntries {
+public:
+    typedef LayoutNode<Key> Node;
+
+    static constexpr std::size_t BlockSize = 4096;
+
+    LayoutEntries() = default;
+    LayoutEntries(LayoutEntries&&) = default;
+    LayoutEntries& operator=(LayoutEntries&&) = default;
+
+    // Обычная копия делила бы блоки без пометки и правила бы их вместе с оригиналом, поэтому копирование — только через share
+    LayoutEntries(const LayoutEntries&) = delete;
+    LayoutEntries& operator=(const LayoutEntries&) = delete;
+
+    std::size_t size() const {
+        return total;
+    }
+
+    bool empty() const {
+        return total == 0;
+    }
+
+    const Node& operator[](std::size_t index) const {
+        const Block& block = blocks[blockOf(index)];
+        return (*block.entries)[index - block.start];
+    }
+
+private:
+    friend class TreeLayout<Key>;
+
+    struct Block {
+        std::shared_ptr<std::vector<Node>> entries;
+        std::size_t start;  // Индекс первой записи блока
+        std::uint64_t generation;  // Поколение, в котором блок создан: блоки прошлых поколений могут быть общими
+    };
+
+    std::vector<Block> blocks;
+    std::size_t total = 0;
+    std::uint64_t generation = 0;  // Растёт с каждым share
+
+    // Функция для получения копии, которая делит с этими записями все блоки. Общие блоки больше не меняются:
+    // обе стороны перед правкой блока копируют его
+    LayoutEntries share() {
+        generation++;
+        LayoutEntries copy;
+        copy.blocks = blocks;
+        copy.total = total;
+        copy.generation = generation;
+        return copy;
+    }
+
+    // Функция для добавления в конец записей entries[from, to) блоками одного размера, от BlockSize / 2 до BlockSize
+    void append(const std::vector<Node>& entries, std::size_t from, std::size_t to) {
+        std::size_t count = to - from;
+        std::size_t pieces = (count + BlockSize - 1) / BlockSize;
+        for (std::size_t i = 0; i < pieces; i++) {
+            auto first = entries.begin() + from + count * i / pieces;
+            auto last = entries.begin() + from + count * (i + 1) / pieces;
+            blocks.push_back({ std::make_shared<std::vector<Node>>(first, last), total, generation });
+            total += last - first;
+        }
+    }
+
+    std::size_t blockOf(std::size_t index) const {
+        auto next = std::upper_bound(blocks.begin(), blocks.end(), index, [](std::size_t value, const Block& block) {
+            return value < block.start;
+        });
+        return static_cast<std::size_t>(next - blocks.begin()) - 1;
+    }
+
+    // Запись для правки: общий блок сначала копируется
+    Node& edit(std::size_t index) {
+        Block& block = blocks[blockOf(index)];
+        if (block.generation != generation) {
+            block.entries = std::make_shared<std::vector<Node>>(*block.entries);
+            block.generation = generation;
+        }
+        return (*block.entries)[index - block.start];
+    }
+
+    void assign(const std::vector<Node>& entries) {
+        blocks.clear();
+        total = 0;
+        append(entries, 0, entries.size());
+    }
+
+    // Функция для замены отрезка [index, index + count) записями fresh. Блоки, задевающие отрезок, собираются
+    // заново вместе с fresh; слишком маленький результат объединяется с соседним блоком, большой делится на блоки
+    void replace(std::size_t index, std::size_t count, const std::vector<Node>& fresh) {
+        std::size_t first = 0;
+        std::size_t last = 0;  // Задетые блоки [first, last)
+        if (!blocks.empty()) {
+            first = blockOf(std::min(index, total - 1));
+            last = (count != 0 ? blockOf(index + count - 1) : first) + 1;
+        }
+        std::size_t begin = first < blocks.size() ? blocks[first].start : 0;  // Первая запись задетых блоков
+        std::size_t end = last != 0 ? blocks[last - 1].start + blocks[last - 1].entries->size() : 0;
+        if (end - begin - count + fresh.size() < BlockSize / 2) {
+            if (last < blocks.size()) {
+                end += blocks[last++].entries->size();
+            }
+            else if (first > 0) {
+                begin = blocks[--first].start;
+            }
+        }
+
+        std::vector<Node> merged;
+        merged.reserve(end - begin - count + fresh.size());
+        auto copyRange = [&](std::size_t from, std::size_t to) {  // Записи задетых блоков с индексами [from, to)
+            for (std::size_t i = first; i < last; i++) {
+                const std::vector<Node>& entries = *blocks[i].entries;
+                std::size_t start = blocks[i].start;
+                std::size_t low = std::max(from, start);
+                std::size_t high = std::min(to, start + entries.size());
+                if (low < high) {
+                    merged.insert(merged.end(), entries.begin() + (low - start), entries.begin() + (high - start));
+                }
+            }
+        };
+        copyRange(begin, index);
+        merged.insert(merged.end(), fresh.begin(), fresh.end());
+        copyRange(index + count, end);
+
+        std::vector<Block> tail(std::make_move_iterator(blocks.begin() + last), std::make_move_iterator(blocks.end()));  // Блоки правее отрезка
+        blocks.resize(first);
+        total = begin;
+        append(merged, 0, merged.size());
+        for (Block& block : tail) {
+            block.start = total;
+            total += block.entries->size();
+            blocks.push_back(std::move(block));
+        }
+    }
+};
+
+// Кэш раскладки дерева для отрисовки. Узлы лежат в массиве записей (LayoutEntries) в прямом порядке обхода, поэтому
+// поддерево — непрерывный отрезок массива и при отсечении пропускается целиком.
+// По горизонтали узел ставится по своему номеру в симметричном порядке (раскладка Кнута): у дерева поиска
+// ключи идут слева направо по возрастанию, а поддеревья никогда не перекрываются. По вертикали — по глубине.
+// Раскладка строится за O(n), а после одной вставки или удаления обновляется вдоль изменившегося пути.
+// Копируется раскладка только через share: копия делит блоки записей с оригиналом
+template <typename Key>
+class TreeLayout {
+public:
+    typedef LayoutNode<Key> Node;
+    typedef LayoutEntries<Key> Entries;
+
+    static constexpr double Spacing = 50.0;  // Расстояние между соседними столбцами в мировых единицах
+    static constexpr double LevelHeight = 80.0;  // Расстояние между уровнями
+    static constexpr double Radius = 20.0;  // Радиус узла
+
+    // Функция для построения раскладки дерева с корнем root. Размеры поддеревьев берутся из узлов дерева
+    template <typename Tree>
+    void build(const Tree& tree, const typename Tree::Node* root) {
+        std::vector<Node> entries;
+        entries.reserve(tree.getSize(root));
+        collect(tree, root, entries);
+        nodes.assign(entries);
+    }
+
+    // Функция для получения неизменяемой копии раскладки, например для снимка. Копия стоит O(n / BlockSize):
+    // блоки записей общие, и эта раскладка копирует блок перед первой его правкой
+    TreeLayout share() {
+        TreeLayout copy;
+        copy.nodes = nodes.share();
+        return copy;
+    }
+
+    // Функция для обновления раскладки после одного изменения дерева: вставки, удаления или перестройки
+    // поддерева. Спуск от корня идёт только в поддеревья, размер которых изменился, и останавливается на
+    // узлах, потомки которых стали другими: такие поддеревья собираются заново. Для вставки и удаления это
+    // O(высоты) записей и пересборка одного-двух блоков записей. Несколько изменений подряд без update не различаются —
+    // после пакетных операций нужен build
+    template <typename Tree>
+    LayoutChange update(const Tree& tree, const typename Tree::Node* root) {
+        typedef typename Tree::Node TreeNode;
+
+        // Отрезок массива, на месте которого теперь стоит поддерево node
+        struct Slot {
+            std::size_t index;
+            std::uint32_t oldSize;
+            const TreeNode* node;
+            std::uint32_t depth;
+            std::int64_t oldFirst;  // Первый столбец поддерева до и после изменения
+            std::int64_t newFirst;
+            bool hasParent;
+            std::int64_t parentOldRank;
+            std::int64_t parentNewRank;
+        };
+        // Узел пути: запись сохранилась, но поддерево изменилось
+        struct Visited {
+            std::size_t index;
+            std::uint32_t depth;
+            std::int64_t oldFirst;
+            std::int64_t newFirst;
+            std::uint32_t oldSize;
+            std::uint32_t oldLevels;
+        };
+
+        LayoutChange change;
+        std::vector<Visited> visited;
+        std::int64_t shiftFrom = std::numeric_limits<std::int64_t>::max();  // Столбцы правее сдвинулись
+        std::vector<Slot> stack = { { 0, nodes.empty() ? 0u : nodes[0].size, root, 0, 0, 0, false, 0, 0 } };
+
+        // Правый потомок обрабатывается раньше левого: все отложенные отрезки лежат левее текущего,
+        // и сдвиг хвоста массива при пересборке не меняет их индексы
+        while (!stack.empty()) {
+            Slot slot = stack.back();
+            stack.pop_back();
+            const Node* old = slot.oldSize != 0 ? &nodes[slot.index] : nullptr;
+            const TreeNode* node = slot.node;
+            std::int64_t oldRank = old != nullptr ? slot.oldFirst + old->leftSize : 0;
+            std::int64_t newRank = node != nullptr ? slot.newFirst + tree.getSize(node->left) : 0;
+
+            if (slot.hasParent && (old == nullptr || node == nullptr || old->node != node || oldRank != newRank || slot.parentOldRank != slot.parentNewRank)) {
+                // Ребро от родителя сдвинулось, появилось или исчезло
+                if (old != nullptr) {
+                    change.areas.push_back(edgeArea(slot.parentOldRank, oldRank, slot.depth - 1));
+                }
+                if (node != nullptr) {
+                    change.areas.push_back(edgeArea(slot.parentNewRank, newRank, slot.depth - 1));
+                }
+            }
+            if (old == nullptr && node == nullptr) {
+                continue;
+            }
+
+            // Тот же узел или на его место переставлен другой с теми же потомками (удаление узла с двумя потомками)
+            bool replaced = old != nullptr && node != nullptr && old->node != node && sameChildren(slot.index, node);
+            if (old != nullptr && node != nullptr && (old->node == node || replaced)) {
+                if (!replaced && old->size == node->size) {
+                    continue;  // Поддерево не менялось, только, возможно, сдвинулось целиком
+                }
+                if (replaced) {
+                    change.areas.push_back(nodeArea(oldRank, slot.depth));
+                    change.areas.push_back(nodeArea(newRank, slot.depth));
+                }
+                visited.push_back({ slot.index, slot.depth, slot.oldFirst, slot.newFirst, old->size, old->levels });
+                std::uint32_t oldLeft = old->leftSize;
+                std::uint32_t oldRight = old->size - 1 - old->leftSize;
+                stack.push_back({ slot.index + 1, oldLeft, node->left, slot.depth + 1, slot.oldFirst, slot.newFirst, true, oldRank, newRank });
+                stack.push_back({ slot.index + 1 + oldLeft, oldRight, node->right, slot.depth + 1, oldRank + 1, newRank + 1, true, oldRank, newRank });
+                Node& entry = nodes.edit(slot.index);
+                entry.node = node;
+                entry.key = node->key;
+                entry.size = static_cast<std::uint32_t>(node->size);
+                entry.leftSize = static_cast<std::uint32_t>(tree.getSize(node->left));
+                continue;
+            }
+
+            // Поддерево стало другим: собираем его заново и ставим на место старого отрезка
+            std::vector<Node> fresh;
+            collect(tree, node, fresh);
+            std::size_t newSize = fresh.size();
+            std::int64_t first = std::min(slot.oldFirst, slot.newFirst);
+            std::int64_t last = std::max(slot.oldFirst + slot.oldSize, slot.newFirst + static_cast<std::int64_t>(newSize)) - 1;
+            change.areas.push_back({ first * Spacing - Radius, slot.depth * LevelHeight - Radius, last * Spacing + Radius, Unbounded });
+            if (newSize != slot.oldSize) {
+                shiftFrom = std::min(shiftFrom, first);
+            }
+            nodes.replace(slot.index, slot.oldSize, fresh);
+            for (Visited& entry : visited) {
+                if (entry.index > slot.index) {
+                    entry.index += newSize - slot.oldSize;
+                }
+            }
+        }
+
+        // Высоты узлов пути пересчитываются снизу вверх: потомки стоят в массиве после родителя
+        std::sort(visited.begin(), visited.end(), [](const Visited& a, const Visited& b) {
+            return a.index > b.index;
+        });
+        for (const Visited& entry : visited) {
+            updateLevels(entry.index);
+            const Node& node = nodes[entry.index];
+            std::int64_t first = std::min(entry.oldFirst, entry.newFirst);
+            std::int64_t last = std::max(entry.oldFirst + entry.oldSize, entry.newFirst + node.size) - 1;
+            std::uint32_t levels = std::max(entry.oldLevels, node.levels);
+            change.subtrees.push_back({ first * Spacing - Radius, entry.depth * LevelHeight - Radius,
+                                        last * Spacing + Radius, (entry.depth + levels - 1.0) * LevelHeight + Radius });
+        }
+        if (shiftFrom != std::numeric_limits<std::int64_t>::max()) {
+            change.areas.push_back({ shiftFrom * Spacing - Radius, -Unbounded, Unbounded, Unbounded });
+        }
+        return change;
+    }
+
+    const Entries& getNodes() const {
+        return nodes;
+    }
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    // Центр корня в мировых единицах
+    double rootX() const {
+        return nodes.empty() ? 0 : nodes[0].leftSize * Spacing;
+    }
+
+    // Ширина и высота всей раскладки в мировых единицах
+    double width() const {
+        return nodes.empty() ? 0 : (nodes[0].size - 1.0) * Spacing;
+    }
+
+    double height() const {
+        return nodes.empty() ? 0 : (nodes[0].levels - 1.0) * LevelHeight;
+    }
+
+    // Функция для обхода видимой части раскладки в прямоугольнике [left, right] x [top, bottom] мировых единиц.
+    // Поддеревья, которые вместе с ребром от родителя лежат вне прямоугольника, пропускаются целиком.
+    // Поддерево, чья ширина меньше minWidth мировых единиц, не раскрывается, а передаётся в aggregate
+    // для отрисовки одним значком (уровень детализации). Остальные видимые узлы передаются в visit. Время обхода зависит от числа видимых узлов, а не от n
+    template <typename Visitor, typename Aggregate>
+    void visible(double left, double top, double right, double bottom, double minWidth, Visitor visit, Aggregate aggregate) const {
+        // Открытые предки текущего узла: конец отрезка поддерева и столбец
+        struct Open {
+            std::size_t index;
+            std::size_t end;
+            std::int64_t rank;
+        };
+        std::vector<Open> ancestors;
+        std::size_t count = nodes.size();
+        for (std::size_t i = 0; i < count;) {
+            while (!ancestors.empty() && ancestors.back().end <= i) {
+                ancestors.pop_back();
+            }
+            const Node& node = nodes[i];
+            std::int64_t rank = node.leftSize;
+            LayoutPlacement placement;
+            placement.index = i;
+            placement.y = ancestors.size() * LevelHeight;
+            if (!ancestors.empty()) {
+                const Open& parent = ancestors.back();
+                if (i == parent.index + 1 && nodes[parent.index].leftSize != 0) {
+                    rank = parent.rank - (node.size - node.leftSize);  // Левый потомок: правее него его правое поддерево
+                }
+                else {
+                    rank = parent.rank + 1 + node.leftSize;
+                }
+                placement.parentX = parent.rank * Spacing;
+                placement.parentY = placement.y - LevelHeight;
+            }
+            placement.x = rank * Spacing;
+            placement.minX = (rank - node.leftSize) * Spacing;
+            placement.maxX = placement.minX + (node.size - 1.0) * Spacing;
+            placement.bottom = placement.y + (node.levels - 1.0) * LevelHeight;
+            if (ancestors.empty()) {
+                placement.parentX = placement.x;
+                placement.parentY = placement.y;
+            }
+
+            // Поддерево проверяется вместе с ребром от родителя: ребро может пересекать окно, когда оба его конца снаружи
+            double boxLeft = std::min(placement.minX, placement.parentX) - Radius;
+            double boxRight = std::max(placement.maxX, placement.parentX) + Radius;
+            if (boxRight < left || boxLeft > right || placement.parentY - Radius > bottom || placement.bottom + Radius < top) {
+                i += node.size;  // Всё поддерево вне окна
+            }
+            else if (node.size > 1 && (node.size - 1.0) * Spacing < minWidth) {
+                aggregate(placement);
+                i += node.size;
+            }
+            else {
+                visit(placement);
+                ancestors.push_back({ i, i + node.size, rank });
+                i++;
+            }
+        }
+    }
+
+private:
+    static constexpr double Unbounded = std::numeric_limits<double>::infinity();
+
+    Entries nodes;
+
+    // Функция для добавления в out записей поддерева root в прямом порядке обхода
+    template <typename Tree>
+    static void collect(const Tree& tree, const typename Tree::Node* root, std::vector<Node>& out) {
+        typedef typename Tree::Node TreeNode;
+        std::size_t begin = out.size();
+        std::vector<const TreeNode*> stack;
+        if (root != nullptr) {
+            stack.push_back(root);
+        }
+        while (!stack.empty()) {
+            const TreeNode* node = stack.back();
+            stack.pop_back();
+            Node entry = { node, node->key, static_cast<std::uint32_t>(tree.getSize(node)), static_cast<std::uint32_t>(tree.getSize(node->left)), 1 };
+            out.push_back(entry);
+            if (node->right != nullptr) {
+                stack.push_back(node->right);  // Правое поддерево — после левого
+            }
+            if (node->left != nullptr) {
+                stack.push_back(node->left);
+            }
+        }
+
+        // Высоты поддеревьев: потомки стоят в массиве после родителя, поэтому достаточно прохода с конца
+        for (std::size_t i = out.size(); i-- > begin;) {
+            out[i].levels = levelsOf(out, i);
+        }
+    }
+
+    template <typename Array>
+    static std::uint32_t levelsOf(const Array& entries, std::size_t i) {
+        const Node& node = entries[i];
+        std::uint32_t levels = 0;
+        if (node.leftSize != 0) {
+            levels = entries[i + 1].levels;
+        }
+        if (node.size - 1 != node.leftSize) {
+            levels = std::max(levels, entries[i + 1 + node.leftSize].levels);
+        }
+        return levels + 1;
+    }
+
+    void updateLevels(std::size_t i) {
+        nodes.edit(i).levels = levelsOf(nodes, i);
+    }
+
+    // Потомки записи index совпадают с потомками узла дерева
+    template <typename TreeNode>
+    bool sameChildren(std::size_t index, const TreeNode* node) const {
+        const Node& entry = nodes[index];
+        const void* left = entry.leftSize != 0 ? nodes[index + 1].node : nullptr;
+        const void* right = entry.size - 1 != entry.leftSize ? nodes[index + 1 + entry.leftSize].node : nullptr;
+        return left == node->left && right == node->right;
+    }
+
+    static LayoutRect nodeArea(std::int64_t rank, std::uint32_t depth) {
+        return { rank * Spacing - Radius, depth * LevelHeight - Radius, rank * Spacing + Radius, depth * LevelHeight + Radius };
+    }
+
+    static LayoutRect edgeArea(std::int64_t parentRank, std::int64_t childRank, std::uint32_t parentDepth) {
+        return { std::min(parentRank, childRank) * Spacing - Radius, parentDepth * LevelHeight - Radius,
+                 std::max(parentRank, childRank) * Spacing + Radius, (parentDepth + 1.0) * LevelHeight + Radius };
+    }
+};
+
+#endif // TREELAYOUT_H
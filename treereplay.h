@@ -0,0 +1,280 @@
+#ifndef TREEREPLAY_H
+#define TREEREPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "binarytree.h"
+#include "treelayout.h"
+
+// Копия формы дерева для анимации изменений. Копия строится по раскладке снимка, а события журнала
+// (TreeEventLog) повторяются на ней теми же алгоритмами, что и в BinaryTree. Анимация идёт шагами: шаг
+// применяет несколько событий, после чего узлы переставляются, а кадры шага рисуют узлы на пути между
+// старыми и новыми положениями. Узел находится по ключу через хеш-таблицу, поэтому вращение стоит O(1)
+// независимо от глубины узла; положения пересчитываются одним обходом за O(n) на шаг, а не на событие
+template <typename Key, typename Compare = std::less<Key>, typename Hash = std::hash<Key>>
+class TreeReplay {
+public:
+    typedef TreeLayout<Key> Layout;
+    typedef std::int32_t Index;  // Номер узла копии
+
+    static constexpr Index None = -1;
+
+    // Функция для построения копии по раскладке: записи раскладки лежат в прямом порядке обхода,
+    // потомки каждой записи находятся по размерам поддеревьев
+    void reset(const Layout& layout) {
+        const typename Layout::Entries& entries = layout.getNodes();
+        nodes.assign(entries.size(), Node());
+        unused.clear();
+        positions.clear();
+        positions.reserve(entries.size());
+        root = entries.empty() ? None : 0;
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            const typename Layout::Node& entry = entries[i];
+            Node& node = nodes[i];
+            node.key = entry.key;
+            node.alive = true;
+            Index index = static_cast<Index>(i);
+            if (entry.leftSize != 0) {
+                node.left = index + 1;
+                nodes[i + 1].parent = index;
+            }
+            if (entry.size - 1 != entry.leftSize) {
+                node.right = index + 1 + static_cast<Index>(entry.leftSize);
+                nodes[node.right].parent = index;
+            }
+            positions[entry.key] = index;
+        }
+        place();
+        for (Node& node : nodes) {
+            node.fromX = node.toX;
+            node.fromY = node.toY;
+        }
+    }
+
+    std::size_t size() const {
+        return positions.size();
+    }
+
+    // Функция для начала шага: узлы выходят из положений, в которых закончился прошлый шаг
+    void beginStep() {
+        for (Node& node : nodes) {
+            node.fromX = node.toX;
+            node.fromY = node.toY;
+        }
+    }
+
+    // Функция для применения события к копии. Возвращает false, если событие не сходится с копией
+    // (узла с ключом нет или вращать нечего) — значит, копия разошлась с деревом
+    bool apply(const TreeEvent<Key>& event) {
+        switch (event.kind) {
+        case TreeEvent<Key>::Insert:
+            return insert(event.key);
+        case TreeEvent<Key>::Delete:
+            return remove(event.key);
+        case TreeEvent<Key>::RotateLeft:
+            return rotate(event.key, true);
+        case TreeEvent<Key>::RotateRight:
+            return rotate(event.key, false);
+        }
+        return false;
+    }
+
+    // Функция для расстановки узлов после событий шага: столбец — номер в симметричном порядке, строка — глубина,
+    // как в TreeLayout. Новые узлы начинают шаг из положения родителя
+    void place() {
+        std::vector<std::pair<Index, std::uint32_t>> stack;  // Узел и его глубина
+        std::int64_t rank = 0;
+        Index current = root;
+        std::uint32_t depth = 0;
+        while (current != None || !stack.empty()) {
+            while (current != None) {
+                stack.push_back({ current, depth });
+                current = nodes[current].left;
+                depth++;
+            }
+            std::pair<Index, std::uint32_t> top = stack.back();
+            stack.pop_back();
+            Node& node = nodes[top.first];
+            node.toX = rank++ * Layout::Spacing;
+            node.toY = top.second * Layout::LevelHeight;
+            current = node.right;
+            depth = top.second + 1;
+        }
+        for (Node& node : nodes) {
+            if (node.alive && node.fresh) {
+                const Node* origin = node.parent != None ? &nodes[node.parent] : &node;
+                node.fromX = origin->fresh ? origin->toX : origin->fromX;
+                node.fromY = origin->fresh ? origin->toY : origin->fromY;
+            }
+        }
+        for (Node& node : nodes) {
+            node.fresh = false;
+        }
+    }
+
+    // Функция для обхода узлов в положении доли t шага (0 — начало, 1 — конец): visit(x, y, parentX, parentY, key).
+    // У корня положение родителя совпадает с его собственным
+    template <typename Visitor>
+    void frame(double t, Visitor visit) const {
+        for (const Node& node : nodes) {
+            if (!node.alive) {
+                continue;
+            }
+            double x = node.fromX + (node.toX - node.fromX) * t;
+            double y = node.fromY + (node.toY - node.fromY) * t;
+            if (node.parent == None) {
+                visit(x, y, x, y, node.key);
+                continue;
+            }
+            const Node& parent = nodes[node.parent];
+            visit(x, y, parent.fromX + (parent.toX - parent.fromX) * t, parent.fromY + (parent.toY - parent.fromY) * t, node.key);
+        }
+    }
+
+private:
+    struct Node {
+        Key key{};
+        Index left = None;
+        Index right = None;
+        Index parent = None;
+        bool alive = false;
+        bool fresh = false;  // Вставлен в текущем шаге, положения до шага у него нет
+        double fromX = 0;  // Положение в начале шага
+        double fromY = 0;
+        double toX = 0;  // Положение в конце шага
+        double toY = 0;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Index> unused;  // Места удалённых узлов
+    std::unordered_map<Key, Index, Hash> positions;  // Номер узла по ключу
+    Index root = None;
+    Compare comp;
+
+    // Ссылка, в которой висит узел: поле потомка у родителя или корень
+    Index& link(Index index) {
+        Index parent = nodes[index].parent;
+        if (parent == None) {
+            return root;
+        }
+        return nodes[parent].left == index ? nodes[parent].left : nodes[parent].right;
+    }
+
+    void setParent(Index child, Index parent) {
+        if (child != None) {
+            nodes[child].parent = parent;
+        }
+    }
+
+    // Вставка тем же спуском от корня, что и в BinaryTree::emplace
+    bool insert(const Key& key) {
+        Index parent = None;
+        Index* slot = &root;
+        while (*slot != None) {
+            parent = *slot;
+            if (comp(key, nodes[parent].key)) {
+                slot = &nodes[parent].left;
+            }
+            else if (comp(nodes[parent].key, key)) {
+                slot = &nodes[parent].right;
+            }
+            else {
+                return false;  // Повторные вставки в журнал не попадают
+            }
+        }
+        Index index;
+        if (!unused.empty()) {
+            index = unused.back();
+            unused.pop_back();
+        }
+        else {
+            index = static_cast<Index>(nodes.size());
+            nodes.emplace_back();
+        }
+        Node& node = nodes[index];  // Ссылка берётся после emplace_back: массив мог переехать
+        node = Node();
+        node.key = key;
+        node.parent = parent;
+        node.alive = true;
+        node.fresh = true;
+        if (parent == None) {
+            root = index;
+        }
+        else if (comp(key, nodes[parent].key)) {
+            nodes[parent].left = index;
+        }
+        else {
+            nodes[parent].right = index;
+        }
+        positions[key] = index;
+        return true;
+    }
+
+    // Удаление как в BinaryTree::deleteNode: узел с двумя потомками заменяется минимальным узлом правого поддерева
+    bool remove(const Key& key) {
+        auto found = positions.find(key);
+        if (found == positions.end()) {
+            return false;
+        }
+        Index index = found->second;
+        positions.erase(found);
+        Node& node = nodes[index];
+        if (node.left != None && node.right != None) {
+            Index minIndex = node.right;
+            while (nodes[minIndex].left != None) {
+                minIndex = nodes[minIndex].left;
+            }
+            Node& minNode = nodes[minIndex];
+            link(minIndex) = minNode.right;  // Вынимаем минимальный узел, у него нет левого потомка
+            setParent(minNode.right, minNode.parent);
+            link(index) = minIndex;
+            minNode.parent = node.parent;
+            minNode.left = node.left;
+            minNode.right = node.right;
+            setParent(minNode.left, minIndex);
+            setParent(minNode.right, minIndex);
+        }
+        else {
+            Index child = node.left != None ? node.left : node.right;
+            link(index) = child;
+            setParent(child, node.parent);
+        }
+        node.alive = false;
+        unused.push_back(index);
+        return true;
+    }
+
+    // Вращение вокруг узла key: левое поднимает правого потомка, правое — левого
+    bool rotate(const Key& key, bool left) {
+        auto found = positions.find(key);
+        if (found == positions.end()) {
+            return false;
+        }
+        Index x = found->second;
+        Index y = left ? nodes[x].right : nodes[x].left;
+        if (y == None) {
+            return false;
+        }
+        Index middle = left ? nodes[y].left : nodes[y].right;  // Поддерево, которое переходит от y к x
+        link(x) = y;
+        nodes[y].parent = nodes[x].parent;
+        if (left) {
+            nodes[x].right = middle;
+            nodes[y].left = x;
+        }
+        else {
+            nodes[x].left = middle;
+            nodes[y].right = x;
+        }
+        nodes[x].parent = y;
+        setParent(middle, x);
+        return true;
+    }
+};
+
+#endif // TREEREPLAY_H
@@ -0,0 +1,448 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "binarytree.h"
+#include "treeio.h"
+
+// Операция, записанная в журнал
+enum class WalOperation : std::uint8_t {
+    Insert = 1,
+    Delete = 2
+};
+
+// Журнал упреждающей записи (write-ahead log) операций над множеством ключей. Файл начинается с заголовка
+// TreeFileHeader (magic "BTREEWAL"), за ним идут записи фиксированного размера: операция, ключ и
+// контрольная сумма. Оборванная при сбое последняя запись не проходит проверку и отрезается при открытии.
+//
+// Групповая фиксация: append только добавляет запись в буфер памяти, а на диск буфер уходит одной записью
+// и одним fsync на все накопленные операции. При groupWindow == 0 сбрасывает тот, кто первым вызвал commit,
+// захватывая и записи других потоков. При groupWindow > 0 сбрасывает фоновый поток раз в groupWindow,
+// поэтому операции всех потоков за это окно делят один fsync. commit(lsn) ждёт, пока запись lsn не окажется на диске
+template <typename Key>
+class WriteAheadLog {
+public:
+    // Конструктор открывает или создаёт журнал. Уже лежащие в нём записи по порядку передаются replay(операция, ключ)
+    template <typename Replay>
+    WriteAheadLog(const std::string& path, std::chrono::microseconds groupWindow, Replay replay)
+        : path(path), groupWindow(groupWindow), appended(0), durable(0), records(0), syncs(0), flushing(false), stopping(false) {
+        static_assert(std::is_trivially_copyable<Key>::value, "WriteAheadLog stores keys as raw bytes");
+        open(replay);
+        if (groupWindow.count() > 0) {
+            flusher = std::thread([this] { flushPeriodically(); });
+        }
+    }
+
+    // Деструктор сбрасывает на диск все добавленные записи
+    ~WriteAheadLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        flushCondition.notify_all();
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        while (flushing) {
+            durableCondition.wait(lock);
+        }
+        if (!buffer.empty()) {
+            flushLocked(lock);
+        }
+        closeFile(descriptor);
+    }
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    // Функция для добавления записи, возвращает её номер (LSN). Запись ещё не на диске, см. commit
+    std::uint64_t append(WalOperation operation, const Key& key) {
+        char record[RecordSize];
+        record[0] = static_cast<char>(operation);
+        std::memcpy(record + 1, &key, sizeof(Key));
+        std::uint32_t check = static_cast<std::uint32_t>(treeChecksum(record, 1 + sizeof(Key)));
+        std::memcpy(record + 1 + sizeof(Key), &check, sizeof(check));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer.insert(buffer.end(), record, record + RecordSize);
+        records++;
+        return ++appended;
+    }
+
+    // Функция для ожидания, пока запись lsn и все предыдущие не окажутся на диске
+    void commit(std::uint64_t lsn) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (durable < lsn) {
+            if (!failure.empty()) {
+                throw std::runtime_error(failure);
+            }
+            if (groupWindow.count() == 0 && !flushing) {
+                flushLocked(lock);  // Этот поток становится ведущим и сбрасывает записи всех ожидающих
+            }
+            else {
+                durableCondition.wait(lock);
+            }
+        }
+    }
+
+    // Функция для ожидания, пока на диске не окажутся все записи, добавленные до вызова
+    void commit() {
+        std::uint64_t lsn;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            lsn = appended;
+        }
+        commit(lsn);
+    }
+
+    // Функция для очистки журнала после контрольной точки: все записи уже учтены в сохранённом дереве,
+    // поэтому и несброшенные записи считаются зафиксированными
+    void truncate() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (flushing) {
+            durableCondition.wait(lock);
+        }
+        buffer.clear();
+        if (!truncateFile(descriptor, sizeof(TreeFileHeader)) || !syncDescriptor(descriptor)) {
+            throw std::runtime_error(path + ": cannot truncate log");
+        }
+        records = 0;
+        durable = appended;
+        durableCondition.notify_all();
+    }
+
+    // Число записей в журнале с последней очистки
+    std::uint64_t size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return records;
+    }
+
+    // Число выполненных fsync: по нему видно, сколько операций в среднем делят один сброс
+    std::uint64_t syncCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return syncs;
+    }
+
+private:
+    static constexpr std::size_t RecordSize = 1 + sizeof(Key) + sizeof(std::uint32_t);
+
+    std::string path;
+    std::chrono::microseconds groupWindow;
+    int descriptor = -1;
+    std::vector<char> buffer;  // Добавленные, но ещё не записанные в файл записи
+    std::uint64_t appended;  // LSN последней добавленной записи
+    std::uint64_t durable;  // LSN последней записи на диске
+    std::uint64_t records;
+    std::uint64_t syncs;
+    bool flushing;  // Идёт запись в файл вне блокировки
+    bool stopping;
+    std::string failure;  // Ошибка записи: дальнейшие commit не могут быть выполнены
+    mutable std::mutex mutex;
+    std::condition_variable durableCondition;
+    std::condition_variable flushCondition;
+    std::thread flusher;
+
+    // Функция для открытия журнала: проверка заголовка, воспроизведение записей и отрезание оборванного хвоста
+    template <typename Replay>
+    void open(Replay& replay) {
+        descriptor = openFile(path);
+        if (descriptor < 0) {
+            throw std::runtime_error(path + ": cannot open log");
+        }
+
+        std::vector<char> contents;
+        char chunk[1 << 16];
+        long long bytes;
+        while ((bytes = readFile(descriptor, chunk, sizeof(chunk))) > 0) {
+            contents.insert(contents.end(), chunk, chunk + bytes);
+        }
+
+        TreeFileHeader header = {};
+        if (contents.size() < sizeof(TreeFileHeader)) {
+            // Новый журнал или сбой до записи заголовка
+            std::memcpy(header.magic, "BTREEWAL", 8);
+            header.version = TreeFileVersion;
+            header.keySize = sizeof(Key);
+            header.byteOrder = ByteOrderMark;
+            if (!truncateFile(descriptor, 0) || !writeFile(descriptor, &header, sizeof(header)) || !syncDescriptor(descriptor)) {
+                closeFile(descriptor);
+                throw std::runtime_error(path + ": cannot create log");
+            }
+            syncDirectory(path);
+            return;
+        }
+
+        std::memcpy(&header, contents.data(), sizeof(header));
+        if (std::memcmp(header.magic, "BTREEWAL", 8) != 0 || header.version != TreeFileVersion
+            || header.keySize != sizeof(Key) || header.byteOrder != ByteOrderMark) {
+            closeFile(descriptor);
+            throw std::runtime_error(path + ": not a compatible log");
+        }
+
+        std::size_t offset = sizeof(TreeFileHeader);
+        for (; offset + RecordSize <= contents.size(); offset += RecordSize) {
+            const char* record = contents.data() + offset;
+            std::uint32_t check;
+            std::memcpy(&check, record + 1 + sizeof(Key), sizeof(check));
+            WalOperation operation = static_cast<WalOperation>(record[0]);
+            if (check != static_cast<std::uint32_t>(treeChecksum(record, 1 + sizeof(Key)))
+                || (operation != WalOperation::Insert && operation != WalOperation::Delete)) {
+                break;  // Запись оборвана сбоем: всё после неё не было зафиксировано
+            }
+            Key key;
+            std::memcpy(&key, record + 1, sizeof(Key));
+            replay(operation, key);
+            records++;
+        }
+        if (offset != contents.size() && (!truncateFile(descriptor, offset) || !syncDescriptor(descriptor))) {
+            closeFile(descriptor);
+            throw std::runtime_error(path + ": cannot truncate log");
+        }
+    }
+
+    // Функция для записи буфера в файл. Вызывается под блокировкой, но пишет без неё,
+    // чтобы другие потоки тем временем добавляли записи в следующую группу
+    void flushLocked(std::unique_lock<std::mutex>& lock) {
+        std::vector<char> group;
+        group.swap(buffer);
+        std::uint64_t lsn = appended;
+        flushing = true;
+        lock.unlock();
+        bool ok = writeFile(descriptor, group.data(), group.size()) && syncDescriptor(descriptor);
+        lock.lock();
+        flushing = false;
+        syncs++;
+        if (ok) {
+            durable = lsn > durable ? lsn : durable;  // truncate мог уже отметить эти записи
+        }
+        else {
+            failure = path + ": cannot write log";
+        }
+        durableCondition.notify_all();
+    }
+
+    void flushPeriodically() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            flushCondition.wait_for(lock, groupWindow);
+            if (!buffer.empty() && !flushing && failure.empty()) {
+                flushLocked(lock);
+            }
+        }
+    }
+
+    // Обёртки над вызовами системы: журнал пишется мимо буферов stdio, чтобы fsync видел все данные
+#if defined(_WIN32)
+    static int openFile(const std::string& path) {
+        return _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    }
+
+    static long long readFile(int descriptor, void* data, std::size_t bytes) {
+        return _read(descriptor, data, static_cast<unsigned>(bytes));
+    }
+
+    static bool writeFile(int descriptor, const void* data, std::size_t bytes) {
+        _lseeki64(descriptor, 0, SEEK_END);
+        return _write(descriptor, data, static_cast<unsigned>(bytes)) == static_cast<int>(bytes);
+    }
+
+    static bool syncDescriptor(int descriptor) {
+        return _commit(descriptor) == 0;
+    }
+
+    static bool truncateFile(int descriptor, std::size_t bytes) {
+        return _chsize_s(descriptor, static_cast<long long>(bytes)) == 0;
+    }
+
+    static void closeFile(int descriptor) {
+        if (descriptor >= 0) {
+            _close(descriptor);
+        }
+    }
+#else
+    static int openFile(const std::string& path) {
+        return ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+
+    static long long readFile(int descriptor, void* data, std::size_t bytes) {
+        return ::read(descriptor, data, bytes);
+    }
+
+    static bool writeFile(int descriptor, const void* data, std::size_t bytes) {
+        if (::lseek(descriptor, 0, SEEK_END) < 0) {
+            return false;
+        }
+        const char* remaining = static_cast<const char*>(data);
+        while (bytes > 0) {
+            ssize_t written = ::write(descriptor, remaining, bytes);
+            if (written <= 0) {
+                return false;
+            }
+            remaining += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    static bool syncDescriptor(int descriptor) {
+#if defined(__linux__)
+        return ::fdatasync(descriptor) == 0;  // Метаданные, кроме размера файла, для восстановления не нужны
+#else
+        return ::fsync(descriptor) == 0;
+#endif
+    }
+
+    static bool truncateFile(int descriptor, std::size_t bytes) {
+        return ::ftruncate(descriptor, static_cast<off_t>(bytes)) == 0;
+    }
+
+    static void closeFile(int descriptor) {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+    }
+#endif
+};
+
+// Дерево-множество с журналом: каждое изменение записывается в журнал path + ".wal", а раз в checkpointEvery
+// записей всё дерево сохраняется контрольной точкой в path + ".tree" (saveTree) и журнал очищается.
+// При открытии дерево загружается из контрольной точки и поверх неё воспроизводится журнал.
+// Вставка и удаление ключа в множестве идемпотентны, поэтому сбой между сохранением контрольной точки и
+// очисткой журнала безопасен: повторное воспроизведение уже учтённых записей даёт то же дерево.
+// Методы можно вызывать из нескольких потоков: изменения дерева идут под мьютексом, а commit ждёт без него
+template <typename Key, typename Compare = std::less<Key>>
+class DurableTree {
+public:
+    typedef BinaryTree<Key, void, Compare> Tree;
+
+    explicit DurableTree(const std::string& path,
+                         std::chrono::microseconds groupWindow = std::chrono::microseconds(1000),
+                         std::uint64_t checkpointEvery = 1 << 20)
+        : checkpointPath(path + ".tree"),
+          checkpointEvery(checkpointEvery),
+          tree(true),
+          checkpointLoaded(loadCheckpoint()),
+          log(path + ".wal", groupWindow, [this](WalOperation operation, const Key& key) { apply(operation, key); }) {}
+
+    DurableTree(const DurableTree&) = delete;
+    DurableTree& operator=(const DurableTree&) = delete;
+
+    // Функция для вставки ключа, возвращает номер записи в журнале для commit
+    std::uint64_t insert(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.root = tree.insert(tree.root, key);
+        return logged(WalOperation::Insert, key);
+    }
+
+    // Функция для удаления ключа, возвращает номер записи в журнале для commit
+    std::uint64_t deleteNode(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.root = tree.deleteNode(tree.root, key);
+        return logged(WalOperation::Delete, key);
+    }
+
+    // Функция для ожидания, пока изменение lsn не окажется на диске
+    void commit(std::uint64_t lsn) {
+        log.commit(lsn);
+    }
+
+    // Функция для ожидания, пока на диске не окажутся все сделанные изменения
+    void commit() {
+        log.commit();
+    }
+
+    bool contains(const Key& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tree.search(tree.root, key) != nullptr;
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tree.getSize(tree.root);
+    }
+
+    // Симметричный обход под блокировкой
+    template <typename Visitor>
+    void inOrderTraversal(Visitor visit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tree.inOrderTraversal(tree.root, visit);
+    }
+
+    // Функция для внеочередной контрольной точки
+    void checkpoint() {
+        std::lock_guard<std::mutex> lock(mutex);
+        checkpointLocked();
+    }
+
+    const WriteAheadLog<Key>& getLog() const {
+        return log;
+    }
+
+private:
+    std::string checkpointPath;
+    std::uint64_t checkpointEvery;
+    std::mutex mutex;
+    Tree tree;
+    bool checkpointLoaded;  // Порядок членов важен: контрольная точка загружается после tree и до воспроизведения log
+    WriteAheadLog<Key> log;
+
+    // Функция для применения записи журнала при восстановлении
+    void apply(WalOperation operation, const Key& key) {
+        if (operation == WalOperation::Insert) {
+            tree.root = tree.insert(tree.root, key);
+        }
+        else {
+            tree.root = tree.deleteNode(tree.root, key);
+        }
+    }
+
+    // Функция для загрузки последней контрольной точки, если она есть
+    bool loadCheckpoint() {
+        std::FILE* file = std::fopen(checkpointPath.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::fclose(file);
+        loadTree(tree, checkpointPath);
+        return true;
+    }
+
+    // Функция для записи выполненного изменения в журнал и контрольной точки при переполнении журнала
+    std::uint64_t logged(WalOperation operation, const Key& key) {
+        std::uint64_t lsn = log.append(operation, key);
+        if (log.size() >= checkpointEvery) {
+            checkpointLocked();
+        }
+        return lsn;
+    }
+
+    void checkpointLocked() {
+        saveTree(tree, checkpointPath);
+        log.truncate();
+    }
+};
+
+#endif // WAL_H